@@ -0,0 +1,131 @@
+// ==============================================
+// Description: Walker/Vose alias table for O(1) draws from a discrete
+//              distribution over pre-parsed integer error codes
+// ==============================================
+
+#ifndef ALIAS_SAMPLER_H
+#define ALIAS_SAMPLER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+class AliasSampler {
+public:
+    // One column of the alias table. The code and its alias share a cache line with the
+    // threshold, so a draw touches exactly one entry.
+    struct Column {
+        std::uint64_t threshold; // P(keep code) scaled to 2^64
+        int code;
+        int alias;
+    };
+
+    AliasSampler() = default;
+
+    // Build the table from parallel vectors of error codes and their (non-negative) weights.
+    AliasSampler(const std::vector<int>& codes, const std::vector<double>& weights) {
+        if (codes.empty() || codes.size() != weights.size()) {
+            throw std::invalid_argument("Error: AliasSampler needs one weight per error code.");
+        }
+        double total = 0.0;
+        for (double w : weights) {
+            if (w < 0.0) {
+                throw std::invalid_argument("Error: AliasSampler weights must be non-negative.");
+            }
+            total += w;
+        }
+        if (total <= 0.0) {
+            throw std::invalid_argument("Error: AliasSampler weights must not all be zero.");
+        }
+
+        // Vose's algorithm: scale the probabilities so that the average column holds 1.0,
+        // then pair every under-full column with an over-full one.
+        const std::size_t k = codes.size();
+        std::vector<double> scaled(k);
+        std::vector<std::size_t> small, large;
+        for (std::size_t i = 0; i < k; ++i) {
+            scaled[i] = weights[i] * static_cast<double>(k) / total;
+            (scaled[i] < 1.0 ? small : large).push_back(i);
+        }
+
+        table_.resize(k);
+        while (!small.empty() && !large.empty()) {
+            const std::size_t s = small.back();
+            small.pop_back();
+            const std::size_t l = large.back();
+            table_[s] = {toThreshold(scaled[s]), codes[s], codes[l]};
+            scaled[l] -= 1.0 - scaled[s];
+            if (scaled[l] < 1.0) {
+                large.pop_back();
+                small.push_back(l);
+            }
+        }
+        // Whatever is left is full up to rounding error and never uses its alias.
+        for (std::size_t i : large) {
+            table_[i] = {UINT64_MAX, codes[i], codes[i]};
+        }
+        for (std::size_t i : small) {
+            table_[i] = {UINT64_MAX, codes[i], codes[i]};
+        }
+    }
+
+    // Adopt a table that was built earlier, e.g. loaded from a precompiled binary file.
+    explicit AliasSampler(std::vector<Column> columns) : table_(std::move(columns)) {
+        if (table_.empty()) {
+            throw std::invalid_argument("Error: AliasSampler needs at least one column.");
+        }
+    }
+
+    // Draw one error code. A single 64-bit random number is split by a 64x64->128 multiply:
+    // the high half selects the column, the low half is the uniform fraction compared
+    // against the column threshold.
+    template <class URBG>
+    int operator()(URBG& gen) const {
+        static_assert(URBG::max() - URBG::min() == UINT64_MAX, "AliasSampler needs a 64-bit engine");
+        const std::uint64_t x = static_cast<std::uint64_t>(gen() - URBG::min());
+        const unsigned __int128 m = static_cast<unsigned __int128>(x) * table_.size();
+        const Column& c = table_[static_cast<std::size_t>(m >> 64)];
+        return static_cast<std::uint64_t>(m) < c.threshold ? c.code : c.alias;
+    }
+
+    // Fill out[0..count) with error codes. Random numbers are generated a block at a time
+    // so that the engine loop and the table lookup loop each run without dependencies on
+    // the other, which lets the compiler pipeline (and partly vectorize) both.
+    template <class URBG>
+    void fill(URBG& gen, int* out, std::size_t count) const {
+        static_assert(URBG::max() - URBG::min() == UINT64_MAX, "AliasSampler needs a 64-bit engine");
+        constexpr std::size_t kBlock = 256;
+        std::uint64_t random[kBlock];
+        const Column* table = table_.data();
+        const std::uint64_t k = table_.size();
+        while (count > 0) {
+            const std::size_t len = count < kBlock ? count : kBlock;
+            for (std::size_t i = 0; i < len; ++i) {
+                random[i] = static_cast<std::uint64_t>(gen() - URBG::min());
+            }
+            for (std::size_t i = 0; i < len; ++i) {
+                const unsigned __int128 m = static_cast<unsigned __int128>(random[i]) * k;
+                const Column& c = table[static_cast<std::size_t>(m >> 64)];
+                out[i] = static_cast<std::uint64_t>(m) < c.threshold ? c.code : c.alias;
+            }
+            out += len;
+            count -= len;
+        }
+    }
+
+    std::size_t size() const { return table_.size(); }
+    const std::vector<Column>& columns() const { return table_; }
+
+private:
+    static std::uint64_t toThreshold(double p) {
+        // 2^64 as a double; p is in [0, 1) here
+        const double scaled = p * 18446744073709551616.0;
+        return scaled >= 18446744073709551615.0 ? UINT64_MAX : static_cast<std::uint64_t>(scaled);
+    }
+
+    std::vector<Column> table_;
+};
+
+#endif // ALIAS_SAMPLER_H
@@ -0,0 +1,16 @@
+// ==============================================
+// Description: Counts heap allocations made through operator new. Only
+//              programs that compile allocation_counter.cpp into their
+//              executable (the tools do) get the counting operator new.
+// ==============================================
+
+#ifndef ALLOCATION_COUNTER_H
+#define ALLOCATION_COUNTER_H
+
+#include <cstdint>
+
+// Number of calls to operator new since the program started, and the bytes they requested
+std::uint64_t allocationCount();
+std::uint64_t allocatedBytes();
+
+#endif // ALLOCATION_COUNTER_H
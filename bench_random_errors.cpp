@@ -0,0 +1,333 @@
+// ==============================================
+// Description: Benchmark suite for the random_errors library. Measures
+//              loading, table construction, single draws, bulk fills,
+//              multi-threaded scaling and histogramming, writes the results
+//              as JSON and optionally fails on regressions against a
+//              baseline file written by an earlier run.
+// ==============================================
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "command_line.h"
+#include "random_errors.h"
+
+using json = nlohmann::json;
+
+namespace {
+
+// One measured quantity. Times are better when lower, throughputs when higher.
+struct Result {
+    std::string name;
+    std::string unit;
+    double value;
+    bool higherIsBetter;
+};
+
+// Repetitions of every measurement; the best one is reported, which is the least noisy
+// estimate of what the code can do on an otherwise idle machine
+constexpr int kRepetitions = 5;
+
+// Keeps the compiler from discarding the measured work
+volatile std::uint64_t sink = 0;
+
+double bestSeconds(const std::function<void()>& work) {
+    double best = 1e300;
+    for (int r = 0; r < kRepetitions; ++r) {
+        const auto start = std::chrono::steady_clock::now();
+        work();
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        best = std::min(best, elapsed.count());
+    }
+    return best;
+}
+
+// The benchmark distributions: a queue with a single code, a typical site and a synthetic
+// wide queue with Zipf-like counts over 4096 codes
+std::map<std::string, std::map<std::string, int>> benchmarkQueues(const std::string& input_file) {
+    std::map<std::string, std::map<std::string, int>> queues;
+    queues["single"] = {{"0", 1000}};
+    std::optional<std::map<std::string, int>> typical = loadQueue(input_file, "AGLT2");
+    if (!typical) {
+        throw std::runtime_error("Error: " + input_file + " has no AGLT2 queue.");
+    }
+    queues["typical"] = std::move(*typical);
+    for (int code = 0; code < 4096; ++code) {
+        queues["wide"][std::to_string(code)] = 1000000 / (code + 1) + 1;
+    }
+    return queues;
+}
+
+const char* modeName(ErrorCodeDistribution::FillMode mode) {
+    switch (mode) {
+    case ErrorCodeDistribution::FillMode::Alias: return "alias";
+    case ErrorCodeDistribution::FillMode::SkipAhead: return "skip";
+    case ErrorCodeDistribution::FillMode::Vector: return "vector";
+    case ErrorCodeDistribution::FillMode::Exact: return "exact";
+    case ErrorCodeDistribution::FillMode::Constant: return "constant";
+    default: return "auto";
+    }
+}
+
+void benchLoading(const std::string& input_file, std::vector<Result>& results) {
+    results.push_back({"load/json_queue", "ms", 1e3 * bestSeconds([&] {
+        sink = sink + loadQueue(input_file, "AGLT2")->size();
+    }), false});
+    results.push_back({"load/json_all", "ms", 1e3 * bestSeconds([&] {
+        sink = sink + loadAllQueues(input_file).size();
+    }), false});
+
+    // Compile to a temporary binary file, then time opening it and building a distribution
+    const std::string binary_file = (std::filesystem::temp_directory_path() / "bench_random_errors.bin").string();
+    {
+        std::ofstream out(binary_file, std::ios::binary | std::ios::trunc);
+        error_code_binary::write(loadAllQueues(input_file), out);
+    }
+    results.push_back({"load/binary_queue", "ms", 1e3 * bestSeconds([&] {
+        sink = sink + loadDistribution(binary_file, "AGLT2")->codes().size();
+    }), false});
+    std::remove(binary_file.c_str());
+}
+
+void benchConstruction(const std::map<std::string, std::map<std::string, int>>& queues,
+                       std::vector<Result>& results) {
+    for (const auto& [name, errorCodes] : queues) {
+        const int builds = name == "wide" ? 100 : 10000;
+        const double seconds = bestSeconds([&] {
+            for (int i = 0; i < builds; ++i) {
+                ErrorCodeDistribution distribution(errorCodes);
+                sink = sink + distribution.codes().size();
+            }
+        });
+        results.push_back({"construct/" + name, "us", 1e6 * seconds / builds, false});
+    }
+}
+
+void benchDraws(const std::map<std::string, std::shared_ptr<const ErrorCodeDistribution>>& distributions,
+                std::uint64_t n, std::vector<Result>& results) {
+    for (const auto& [name, distribution] : distributions) {
+        ErrorCodeGenerator generator(distribution, 1);
+        const double seconds = bestSeconds([&] {
+            std::uint64_t sum = 0;
+            for (std::uint64_t i = 0; i < n; ++i) {
+                sum += static_cast<std::uint64_t>(generator.getNextErrorCode());
+            }
+            sink = sink + sum;
+        });
+        results.push_back({"draw/" + name, "ns", 1e9 * seconds / static_cast<double>(n), false});
+    }
+
+    // The engines, on the typical queue
+    const auto& typical = distributions.at("typical");
+    for (const char* engineName : {"xoshiro256", "pcg64", "philox", "mt19937"}) {
+        withEngine(engineName, [&](auto engine) {
+            BasicErrorCodeGenerator<typename decltype(engine)::type> generator(typical, 1);
+            const double seconds = bestSeconds([&] {
+                std::uint64_t sum = 0;
+                for (std::uint64_t i = 0; i < n; ++i) {
+                    sum += static_cast<std::uint64_t>(generator.getNextErrorCode());
+                }
+                sink = sink + sum;
+            });
+            results.push_back({std::string("draw/typical/") + engineName, "ns", 1e9 * seconds / static_cast<double>(n), false});
+        });
+    }
+
+    // The exact integer sampler, on the typical queue
+    ErrorCodeGenerator exact(std::make_shared<const ErrorCodeDistribution>(
+                                 typical->codes(), typical->weights(), typical->aliasSampler(),
+                                 ErrorCodeDistribution::FillMode::Exact),
+                             1);
+    const double seconds = bestSeconds([&] {
+        std::uint64_t sum = 0;
+        for (std::uint64_t i = 0; i < n; ++i) {
+            sum += static_cast<std::uint64_t>(exact.getNextErrorCode());
+        }
+        sink = sink + sum;
+    });
+    results.push_back({"draw/typical/exact", "ns", 1e9 * seconds / static_cast<double>(n), false});
+}
+
+void benchFills(const std::map<std::string, std::map<std::string, int>>& queues, std::uint64_t n,
+                std::vector<Result>& results) {
+    using FillMode = ErrorCodeDistribution::FillMode;
+    std::vector<int> buffer(1 << 16);
+    for (const auto& [name, errorCodes] : queues) {
+        for (FillMode mode : {FillMode::Auto, FillMode::Alias, FillMode::SkipAhead, FillMode::Vector, FillMode::Exact}) {
+            ErrorCodeGenerator generator(std::make_shared<const ErrorCodeDistribution>(errorCodes, mode), 1);
+            const double seconds = bestSeconds([&] {
+                for (std::uint64_t done = 0; done < n; done += buffer.size()) {
+                    generator.fill(buffer);
+                }
+                sink = sink + static_cast<std::uint64_t>(buffer[0]);
+            });
+            const std::uint64_t count = (n + buffer.size() - 1) / buffer.size() * buffer.size();
+            results.push_back({"fill/" + name + "/" + modeName(mode), "Mcodes/s",
+                               static_cast<double>(count) / seconds / 1e6, true});
+        }
+    }
+}
+
+// Largest output buffer of the scaling benchmark (1 GiB of codes)
+constexpr std::uint64_t kMaxScalingCodes = std::uint64_t{1} << 28;
+
+void benchScaling(const std::shared_ptr<const ErrorCodeDistribution>& distribution, std::uint64_t n,
+                  std::vector<Result>& results) {
+    n = std::min(n, kMaxScalingCodes);
+    std::vector<int> out(static_cast<std::size_t>(n));
+    const unsigned hardware = std::max(std::thread::hardware_concurrency(), 1u);
+    for (unsigned threads = 1;; threads = std::min(threads * 2, hardware)) {
+        ParallelGenerator generator(distribution, 1, threads);
+        const double seconds = bestSeconds([&] {
+            generator.fill(out.data(), n);
+            sink = sink + static_cast<std::uint64_t>(out[0]);
+        });
+        results.push_back({"parallel/typical/" + std::to_string(threads) + "t", "Mcodes/s",
+                           static_cast<double>(n) / seconds / 1e6, true});
+        if (threads == hardware) {
+            break;
+        }
+    }
+}
+
+void benchHistograms(const std::map<std::string, std::map<std::string, int>>& queues,
+                     const std::map<std::string, std::shared_ptr<const ErrorCodeDistribution>>& distributions,
+                     std::uint64_t n, std::vector<Result>& results) {
+    for (const auto& [name, distribution] : distributions) {
+        ParallelGenerator generator(distribution, 1, 1);
+        const double seconds = bestSeconds([&] {
+            sink = sink + countErrorCodes(generator, n).size();
+        });
+        results.push_back({"histogram/" + name, "Mcodes/s", static_cast<double>(n) / seconds / 1e6, true});
+    }
+    for (const auto& [name, errorCodes] : queues) {
+        Xoshiro256StarStar gen(1);
+        const int samples = name == "wide" ? 10 : 1000;
+        const double seconds = bestSeconds([&] {
+            for (int i = 0; i < samples; ++i) {
+                sink = sink + sampleMultinomialCounts(errorCodes, 1000000000, gen).size();
+            }
+        });
+        results.push_back({"counts_only/" + name, "us", 1e6 * seconds / samples, false});
+    }
+}
+
+// Function to compare results against a baseline. Prints every result that is worse than the
+// baseline by more than tolerance (a fraction) and returns how many there are.
+int compareWithBaseline(const std::vector<Result>& results, const json& baseline, double tolerance) {
+    std::map<std::string, double> previous;
+    for (const auto& entry : baseline.at("results")) {
+        previous[entry.at("name").get<std::string>()] = entry.at("value").get<double>();
+    }
+    int regressions = 0;
+    for (const Result& result : results) {
+        const auto it = previous.find(result.name);
+        if (it == previous.end() || it->second <= 0.0) {
+            continue;
+        }
+        const double change = result.higherIsBetter ? it->second / result.value - 1.0 : result.value / it->second - 1.0;
+        if (change > tolerance) {
+            std::cout << "Regression: " << result.name << " " << result.value << " " << result.unit
+                      << " (baseline " << it->second << ", " << static_cast<int>(100.0 * change + 0.5) << "% worse)"
+                      << std::endl;
+            ++regressions;
+        }
+    }
+    return regressions;
+}
+
+} // namespace
+
+
+int main(int argc, char* argv[]) {
+
+    Arguments arguments;
+    try {
+        arguments = parseArguments(argc, argv, {});
+    } catch (const std::exception& e) {
+        std::cerr << "Usage: " << argv[0]
+                  << " [--input <input file>] [--n <codes per measurement>] [--output <results.json>]"
+                     " [--baseline <results.json> [--tolerance <fraction>]]" << std::endl;
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    const std::string input_file = arguments.input_file.empty() ? RANDOM_ERRORS_DATA_DIR "/error_codes.json"
+                                                                : arguments.input_file;
+    const std::uint64_t n = arguments.n != 0 ? arguments.n : std::uint64_t{1} << 24;
+
+    std::vector<Result> results;
+    try {
+        const auto queues = benchmarkQueues(input_file);
+        std::map<std::string, std::shared_ptr<const ErrorCodeDistribution>> distributions;
+        for (const auto& [name, errorCodes] : queues) {
+            distributions[name] = std::make_shared<const ErrorCodeDistribution>(errorCodes);
+        }
+
+        benchLoading(input_file, results);
+        benchConstruction(queues, results);
+        benchDraws(distributions, n, results);
+        benchFills(queues, n, results);
+        benchScaling(distributions.at("typical"), std::min(n, kMaxScalingCodes / 4) * 4, results);
+        benchHistograms(queues, distributions, n, results);
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    json report;
+    report["vector_kernel"] = SimdAliasKernel::isa();
+    report["hardware_threads"] = std::thread::hardware_concurrency();
+    report["codes_per_measurement"] = n;
+    report["results"] = json::array();
+    for (const Result& result : results) {
+        std::cout << result.name << ": " << result.value << " " << result.unit << std::endl;
+        report["results"].push_back({{"name", result.name}, {"unit", result.unit}, {"value", result.value},
+                                     {"higher_is_better", result.higherIsBetter}});
+    }
+
+    if (!arguments.output_file.empty()) {
+        std::ofstream out(arguments.output_file);
+        if (!out) {
+            std::cerr << "Error: Could not create " << arguments.output_file << std::endl;
+            return EXIT_FAILURE;
+        }
+        out << report.dump(2) << std::endl;
+    }
+
+    if (!arguments.baseline_file.empty()) {
+        std::ifstream in(arguments.baseline_file);
+        if (!in) {
+            std::cerr << "Error: Could not open " << arguments.baseline_file << std::endl;
+            return EXIT_FAILURE;
+        }
+        int regressions = 0;
+        try {
+            regressions = compareWithBaseline(results, json::parse(in), arguments.tolerance);
+        } catch (const std::exception& e) {
+            std::cerr << "Error: Invalid baseline " << arguments.baseline_file << ": " << e.what() << std::endl;
+            return EXIT_FAILURE;
+        }
+        if (regressions > 0) {
+            std::cout << regressions << " regression(s) beyond " << static_cast<int>(100.0 * arguments.tolerance + 0.5)
+                      << "% of the baseline." << std::endl;
+            return 2;
+        }
+        std::cout << "No regressions beyond " << static_cast<int>(100.0 * arguments.tolerance + 0.5)
+                  << "% of the baseline." << std::endl;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,111 @@
+// ==============================================
+// Description: Portable binomial sampler, so that count vectors sampled
+//              from a seed are the same with every standard library
+//              (std::binomial_distribution uses a different algorithm in
+//              each). Small means use geometric waiting times, large ones
+//              Hörmann's BTRS, transformed rejection with squeeze.
+// ==============================================
+
+#ifndef BINOMIAL_SAMPLER_H
+#define BINOMIAL_SAMPLER_H
+
+#include <cmath>
+#include <cstdint>
+
+namespace binomial_detail {
+
+// Uniform in (0, 1) from the top 53 bits, never 0 so that its logarithm is finite
+template <class URBG>
+double uniform(URBG& gen) {
+    const std::uint64_t x = static_cast<std::uint64_t>(gen() - URBG::min());
+    return (static_cast<double>(x >> 11) + 0.5) * 0x1.0p-53;
+}
+
+// log(k!) - Stirling's approximation of it, exact for small k
+inline double stirlingTail(double k) {
+    static constexpr double kTail[] = {0.0810614667953272,  0.0413406959554092,  0.0276779256849983,
+                                       0.02079067210376509, 0.0166446911898211,  0.0138761288230707,
+                                       0.0118967099458917,  0.0104112652619720,  0.00925546218271273,
+                                       0.00833056343336287};
+    if (k <= 9) {
+        return kTail[static_cast<int>(k)];
+    }
+    const double kp1sq = (k + 1) * (k + 1);
+    return (1.0 / 12 - (1.0 / 360 - 1.0 / 1260 / kp1sq) / kp1sq) / (k + 1);
+}
+
+// Count the geometric waiting times between successes that fit in n trials; O(n p) expected.
+template <class URBG>
+std::uint64_t binomialInversion(URBG& gen, std::uint64_t n, double p) {
+    const double logQ = std::log1p(-p);
+    const double trials = static_cast<double>(n);
+    double sum = 0.0;
+    std::uint64_t successes = 0;
+    for (;;) {
+        sum += std::ceil(std::log(uniform(gen)) / logQ);
+        if (sum > trials) {
+            return successes;
+        }
+        ++successes;
+    }
+}
+
+// BTRS (Hörmann 1993, "The generation of binomial random variates") for n p >= 10 and
+// p <= 0.5: transformed rejection from a hat whose inverse is cheap, with a squeeze that
+// accepts most candidates without any logarithm. The acceptance rate is above 80%, so the cost
+// does not depend on n.
+template <class URBG>
+std::uint64_t binomialBtrs(URBG& gen, std::uint64_t n, double p) {
+    const double trials = static_cast<double>(n);
+    const double stddev = std::sqrt(trials * p * (1 - p));
+    const double b = 1.15 + 2.53 * stddev;
+    const double a = -0.0873 + 0.0248 * b + 0.01 * p;
+    const double c = trials * p + 0.5;
+    const double vr = 0.92 - 4.2 / b;
+    const double r = p / (1 - p);
+    const double alpha = (2.83 + 5.1 / b) * stddev;
+    const double m = std::floor((trials + 1) * p);
+    for (;;) {
+        const double u = uniform(gen) - 0.5;
+        double v = uniform(gen);
+        const double us = 0.5 - std::fabs(u);
+        const double k = std::floor((2 * a / us + b) * u + c);
+        if (us >= 0.07 && v <= vr) {
+            return static_cast<std::uint64_t>(k);
+        }
+        if (k < 0 || k > trials) {
+            continue;
+        }
+        v = std::log(v * alpha / (a / (us * us) + b));
+        const double bound = (m + 0.5) * std::log((m + 1) / (r * (trials - m + 1))) +
+                             (trials + 1) * std::log((trials - m + 1) / (trials - k + 1)) +
+                             (k + 0.5) * std::log(r * (trials - k + 1) / (k + 1)) + stirlingTail(m) +
+                             stirlingTail(trials - m) - stirlingTail(k) - stirlingTail(trials - k);
+        if (v <= bound) {
+            return static_cast<std::uint64_t>(k);
+        }
+    }
+}
+
+} // namespace binomial_detail
+
+// This function returns the number of successes in n independent trials with success
+// probability p. The result only depends on the engine output and IEEE double arithmetic
+// (plus std::log, whose last bit may in rare cases differ between math libraries).
+template <class URBG>
+std::uint64_t sampleBinomial(URBG& gen, std::uint64_t n, double p) {
+    if (n == 0 || p <= 0.0) {
+        return 0;
+    }
+    if (p >= 1.0) {
+        return n;
+    }
+    // Sample the rarer outcome, so that p <= 0.5
+    if (p > 0.5) {
+        return n - sampleBinomial(gen, n, 1.0 - p);
+    }
+    return static_cast<double>(n) * p < 10.0 ? binomial_detail::binomialInversion(gen, n, p)
+                                             : binomial_detail::binomialBtrs(gen, n, p);
+}
+
+#endif // BINOMIAL_SAMPLER_H
@@ -0,0 +1,182 @@
+// ==============================================
+// Description: Buffered writer for generated error codes (see
+//              code_writer.h)
+// ==============================================
+
+#include "code_writer.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+// Largest encoding of one code: "-2147483648\n"
+constexpr std::size_t kMaxRecordSize = 12;
+
+} // namespace
+
+
+CodeWriter::Format CodeWriter::parseFormat(const std::string& name) {
+    if (name == "int16") {
+        return Format::Int16;
+    }
+    if (name == "int32") {
+        return Format::Int32;
+    }
+    if (name == "varint") {
+        return Format::Varint;
+    }
+    if (name == "text") {
+        return Format::Text;
+    }
+    throw std::invalid_argument("Error: Invalid output format " + name + ". It must be int16, int32, varint or text.");
+}
+
+CodeWriter::CodeWriter(const std::string& path, Format format) : format_(format), buffer_(kBufferSize) {
+    if (path == "-") {
+        fd_ = STDOUT_FILENO;
+    } else {
+        fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd_ < 0) {
+            throw std::runtime_error("Error: Could not create " + path + ": " + std::strerror(errno));
+        }
+        ownsFd_ = true;
+    }
+}
+
+CodeWriter::CodeWriter(const std::string& path, Format format, std::uint64_t offset)
+    : format_(format), buffer_(kBufferSize), written_(offset) {
+    fd_ = ::open(path.c_str(), O_WRONLY);
+    if (fd_ < 0) {
+        throw std::runtime_error("Error: Could not open " + path + ": " + std::strerror(errno));
+    }
+    ownsFd_ = true;
+    struct stat status;
+    if (::fstat(fd_, &status) != 0 || !S_ISREG(status.st_mode) || static_cast<std::uint64_t>(status.st_size) < offset) {
+        ::close(fd_);
+        throw std::runtime_error("Error: " + path + " is not a regular file of at least " + std::to_string(offset) +
+                                 " bytes.");
+    }
+    if (::ftruncate(fd_, static_cast<off_t>(offset)) != 0 || ::lseek(fd_, static_cast<off_t>(offset), SEEK_SET) < 0) {
+        const int error = errno;
+        ::close(fd_);
+        throw std::runtime_error("Error: Could not continue " + path + ": " + std::strerror(error));
+    }
+}
+
+CodeWriter::~CodeWriter() {
+    try {
+        close();
+    } catch (const std::exception&) {
+    }
+}
+
+void CodeWriter::write(const int* codes, std::size_t count) {
+    switch (format_) {
+    case Format::Int16:
+        append(codes, count, [](unsigned char* p, int code) -> std::size_t {
+            if (code < INT16_MIN || code > INT16_MAX) {
+                throw std::runtime_error("Error: Error code " + std::to_string(code) + " does not fit in int16.");
+            }
+            const auto value = static_cast<std::uint16_t>(code);
+            p[0] = static_cast<unsigned char>(value);
+            p[1] = static_cast<unsigned char>(value >> 8);
+            return 2;
+        });
+        break;
+    case Format::Int32:
+        append(codes, count, [](unsigned char* p, int code) -> std::size_t {
+            const auto value = static_cast<std::uint32_t>(code);
+            p[0] = static_cast<unsigned char>(value);
+            p[1] = static_cast<unsigned char>(value >> 8);
+            p[2] = static_cast<unsigned char>(value >> 16);
+            p[3] = static_cast<unsigned char>(value >> 24);
+            return 4;
+        });
+        break;
+    case Format::Varint:
+        append(codes, count, [](unsigned char* p, int code) -> std::size_t {
+            // Zigzag maps small negative codes (e.g. -1) to small unsigned values
+            std::uint32_t value = (static_cast<std::uint32_t>(code) << 1) ^ static_cast<std::uint32_t>(code >> 31);
+            std::size_t n = 0;
+            while (value >= 0x80) {
+                p[n++] = static_cast<unsigned char>(value | 0x80);
+                value >>= 7;
+            }
+            p[n++] = static_cast<unsigned char>(value);
+            return n;
+        });
+        break;
+    case Format::Text:
+        append(codes, count, [](unsigned char* p, int code) -> std::size_t {
+            char* first = reinterpret_cast<char*>(p);
+            char* end = std::to_chars(first, first + kMaxRecordSize - 1, code).ptr;
+            *end++ = '\n';
+            return static_cast<std::size_t>(end - first);
+        });
+        break;
+    }
+}
+
+// Encode the codes with encode(unsigned char* out, int code), which returns the number of
+// bytes written. Records are encoded in runs that are sure to fit, so the buffer is checked
+// once per run rather than once per code.
+template <class Encode>
+void CodeWriter::append(const int* codes, std::size_t count, Encode encode) {
+    while (count > 0) {
+        if (used_ + kMaxRecordSize > buffer_.size()) {
+            flush();
+        }
+        const std::size_t len = std::min(count, (buffer_.size() - used_) / kMaxRecordSize);
+        unsigned char* p = buffer_.data() + used_;
+        for (std::size_t i = 0; i < len; ++i) {
+            p += encode(p, codes[i]);
+        }
+        used_ = static_cast<std::size_t>(p - buffer_.data());
+        codes += len;
+        count -= len;
+    }
+}
+
+void CodeWriter::flush() {
+    std::size_t offset = 0;
+    while (offset < used_) {
+        const ssize_t n = ::write(fd_, buffer_.data() + offset, used_ - offset);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            used_ = 0;
+            throw std::runtime_error(std::string("Error: Failed to write error codes: ") + std::strerror(errno));
+        }
+        offset += static_cast<std::size_t>(n);
+    }
+    written_ += used_;
+    used_ = 0;
+}
+
+void CodeWriter::close() {
+    if (fd_ < 0) {
+        return;
+    }
+    try {
+        flush();
+    } catch (...) {
+        if (ownsFd_) {
+            ::close(fd_);
+        }
+        fd_ = -1;
+        throw;
+    }
+    const bool closed = !ownsFd_ || ::close(fd_) == 0;
+    fd_ = -1;
+    if (!closed) {
+        throw std::runtime_error(std::string("Error: Failed to close the output: ") + std::strerror(errno));
+    }
+}
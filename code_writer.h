@@ -0,0 +1,71 @@
+// ==============================================
+// Description: Buffered writer that streams generated error codes to a
+//              file, FIFO or stdout as packed binary records or text
+// ==============================================
+
+#ifndef CODE_WRITER_H
+#define CODE_WRITER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class CodeWriter {
+public:
+    // Record formats. Int16 and Int32 are little-endian two's complement; Varint is the
+    // zigzag-encoded LEB128 of the code (1 byte for codes in [-64, 63], 2 bytes up to
+    // +-8191); Text is one decimal code per line.
+    enum class Format { Int16, Int32, Varint, Text };
+
+    // Size of the output buffer. Data is written to the file only when the buffer is full, so
+    // there are no per-record system calls or flushes.
+    static constexpr std::size_t kBufferSize = 1 << 20;
+
+    // This function returns the format called name (int16, int32, varint or text). Throws
+    // std::invalid_argument for other names.
+    static Format parseFormat(const std::string& name);
+
+    // The constructor opens path for writing, creating or truncating a regular file; "-"
+    // stands for stdout. Throws std::runtime_error if the file cannot be opened.
+    CodeWriter(const std::string& path, Format format);
+
+    // This constructor continues an existing regular file after its first offset bytes, e.g.
+    // those recorded in a checkpoint; anything after them is cut off. bytesWritten() counts
+    // from the start of the file. Throws std::runtime_error if the file cannot be opened or is
+    // shorter than offset.
+    CodeWriter(const std::string& path, Format format, std::uint64_t offset);
+
+    // Flushes what is left; errors at this point are ignored, call close() to see them.
+    ~CodeWriter();
+
+    CodeWriter(const CodeWriter&) = delete;
+    CodeWriter& operator=(const CodeWriter&) = delete;
+
+    // This function appends count codes. Throws std::runtime_error if a code does not fit the
+    // format (Int16) or if writing fails.
+    void write(const int* codes, std::size_t count);
+
+    // This function writes out the buffer, e.g. before bytesWritten() is recorded in a
+    // checkpoint. Throws std::runtime_error if writing fails.
+    void flush();
+
+    // This function writes out the buffer and closes the file. Throws std::runtime_error if
+    // writing fails.
+    void close();
+
+    std::uint64_t bytesWritten() const { return written_ + used_; }
+
+private:
+    template <class Encode>
+    void append(const int* codes, std::size_t count, Encode encode);
+
+    int fd_{-1};
+    bool ownsFd_{false};
+    Format format_;
+    std::vector<unsigned char> buffer_;
+    std::size_t used_{0};
+    std::uint64_t written_{0};
+};
+
+#endif // CODE_WRITER_H
@@ -0,0 +1,139 @@
+// ==============================================
+// Description: Command-line parsing shared by the random-errors tools
+// ==============================================
+
+#include "command_line.h"
+
+#include <stdexcept>
+#include <unordered_map>
+#include <unordered_set>
+#include "random_engines.h"
+
+
+Arguments parseArguments(int argc, char* argv[], const std::vector<std::string>& required) {
+    // Options that take a value
+    static const std::unordered_set<std::string> valueOptions = {
+        "--input", "--output", "--n", "--queue", "--threads", "--seed", "--engine", "--format", "--baseline",
+        "--tolerance", "--produce", "--slots", "--batch", "--serve", "--header", "--checkpoint"};
+    std::unordered_map<std::string, std::string> args;
+    Arguments arguments;
+
+    // Parse command-line arguments
+    for (int i = 1; i < argc; i++) {
+        std::string key = argv[i];
+        if (key == "--counts-only") {
+            arguments.counts_only = true;
+        } else if (key == "--exact") {
+            arguments.exact = true;
+        } else if (key == "--progress") {
+            arguments.progress = true;
+        } else if (key == "--resume") {
+            arguments.resume = true;
+        } else if (key == "--stats" || key == "--stats=text") {
+            arguments.stats = "text";
+        } else if (key == "--stats=json") {
+            arguments.stats = "json";
+        } else if (key.rfind("--stats=", 0) == 0) {
+            throw std::runtime_error("Error: Invalid value for --stats. It must be text or json.");
+        } else if (valueOptions.count(key) != 0 && i + 1 < argc) {
+            args[key] = argv[i + 1];
+            i++; // Skip next as it's a value
+        }
+    }
+
+    // Extract values with validation
+    for (const auto& option : required) {
+        if (args.find(option) == args.end()) {
+            throw std::runtime_error("Error: Missing " + option + " argument.");
+        }
+    }
+
+    arguments.input_file = args["--input"];
+    arguments.output_file = args["--output"];
+    arguments.queue_name = args["--queue"];
+    arguments.baseline_file = args["--baseline"];
+    arguments.produce_name = args["--produce"];
+    arguments.serve_path = args["--serve"];
+    arguments.header_file = args["--header"];
+    arguments.checkpoint_file = args["--checkpoint"];
+    if (arguments.resume && arguments.checkpoint_file.empty()) {
+        throw std::runtime_error("Error: --resume needs --checkpoint <file>.");
+    }
+    if (args.find("--format") != args.end()) {
+        arguments.output_format = args["--format"];
+        if (arguments.output_format != "int16" && arguments.output_format != "int32" &&
+            arguments.output_format != "varint" && arguments.output_format != "text") {
+            throw std::runtime_error("Error: Invalid value for --format. It must be int16, int32, varint or text.");
+        }
+    }
+
+    if (args.find("--n") != args.end()) {
+        // 64-bit, so that a single run can draw 10^10 codes and more
+        const std::string& value = args["--n"];
+        std::size_t end = 0;
+        try {
+            arguments.n = std::stoull(value, &end);
+        } catch (...) {
+            end = 0;
+        }
+        if (end == 0 || end != value.size() || value.find('-') != std::string::npos) {
+            throw std::runtime_error("Error: Invalid value for --n. It must be a non-negative integer.");
+        }
+    }
+    if (args.find("--seed") != args.end()) {
+        // std::stoull would accept a sign and wrap a negative seed around
+        const std::string& value = args["--seed"];
+        std::size_t end = 0;
+        try {
+            arguments.seed = std::stoull(value, &end);
+        } catch (...) {
+            end = 0;
+        }
+        if (end == 0 || end != value.size() || value.find_first_of("+-") != std::string::npos) {
+            throw std::runtime_error("Error: Invalid value for --seed. It must be an unsigned integer.");
+        }
+    } else {
+        // No seed given: draw one, and print it so that the run can be repeated
+        arguments.seed = randomSeed();
+    }
+    auto positive = [&](const std::string& option, std::uint32_t& value) {
+        if (args.find(option) == args.end()) {
+            return;
+        }
+        unsigned long parsed = 0;
+        std::size_t end = 0;
+        try {
+            parsed = std::stoul(args[option], &end);
+        } catch (...) {
+            parsed = 0;
+        }
+        if (parsed == 0 || parsed > 0xffffffffUL || end != args[option].size() ||
+            args[option].find('-') != std::string::npos) {
+            throw std::runtime_error("Error: Invalid value for " + option + ". It must be a positive integer.");
+        }
+        value = static_cast<std::uint32_t>(parsed);
+    };
+    std::uint32_t threads = arguments.threads;
+    positive("--threads", threads);
+    arguments.threads = threads;
+    positive("--slots", arguments.slots);
+    positive("--batch", arguments.batch);
+    if (args.find("--tolerance") != args.end()) {
+        try {
+            arguments.tolerance = std::stod(args["--tolerance"]);
+        } catch (...) {
+            arguments.tolerance = -1.0;
+        }
+        if (arguments.tolerance < 0.0) {
+            throw std::runtime_error("Error: Invalid value for --tolerance. It must be a non-negative fraction.");
+        }
+    }
+    if (args.find("--engine") != args.end()) {
+        arguments.engine = args["--engine"];
+        if (!isEngineName(arguments.engine)) {
+            throw std::runtime_error("Error: Invalid value for --engine. It must be xoshiro256, pcg64, philox or mt19937.");
+        }
+    }
+
+    return arguments;
+}
@@ -0,0 +1,43 @@
+// ==============================================
+// Description: Command-line parsing shared by the random-errors tools
+// ==============================================
+
+#ifndef COMMAND_LINE_H
+#define COMMAND_LINE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Command-line arguments. Each tool uses the subset it needs.
+struct Arguments {
+    std::string input_file;
+    std::string output_file;
+    std::string output_format{"int32"};
+    std::uint64_t n{0};
+    std::string queue_name;
+    bool counts_only{false};
+    bool exact{false};
+    unsigned threads{1};
+    std::uint64_t seed{0};
+    std::string engine{"xoshiro256"};
+    std::string baseline_file;
+    double tolerance{0.10};
+    std::string stats; // "", "text" or "json"
+    bool progress{false};
+    std::string produce_name;
+    std::uint32_t slots{16};
+    std::uint32_t batch{4096};
+    std::string serve_path;
+    std::string header_file;
+    std::string checkpoint_file;
+    bool resume{false};
+};
+
+// Function to parse command-line arguments. The options listed in required must be present.
+// If --seed is not given, a random seed is drawn so that it can be printed and the run
+// repeated. Throws std::runtime_error for missing or invalid values.
+Arguments parseArguments(int argc, char* argv[],
+                         const std::vector<std::string>& required = {"--input", "--n", "--queue"});
+
+#endif // COMMAND_LINE_H
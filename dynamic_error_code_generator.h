@@ -0,0 +1,81 @@
+// ==============================================
+// Description: Random error code generator for one queue whose counts
+//              change while it runs, e.g. fed by live job outcomes. Backed
+//              by a FenwickSampler instead of the immutable alias tables.
+// ==============================================
+
+#ifndef DYNAMIC_ERROR_CODE_GENERATOR_H
+#define DYNAMIC_ERROR_CODE_GENERATOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "error_code_parser.h"
+#include "fenwick_sampler.h"
+#include "random_engines.h"
+
+template <class Engine = Xoshiro256StarStar>
+class BasicDynamicErrorCodeGenerator {
+public:
+    using engine_type = Engine;
+
+    // The constructor parses the error codes once and builds the tree. errorCodes is any
+    // range of (code string, count) pairs, e.g. a std::map<std::string, int>. Throws
+    // std::invalid_argument for codes that are not integers and for negative counts.
+    template <class ErrorCodes>
+    explicit BasicDynamicErrorCodeGenerator(const ErrorCodes& errorCodes)
+        : BasicDynamicErrorCodeGenerator(errorCodes, randomSeed()) {}
+
+    template <class ErrorCodes>
+    BasicDynamicErrorCodeGenerator(const ErrorCodes& errorCodes, std::uint64_t seed)
+        : BasicDynamicErrorCodeGenerator(errorCodes, Engine(seed)) {}
+
+    template <class ErrorCodes>
+    BasicDynamicErrorCodeGenerator(const ErrorCodes& errorCodes, Engine engine) : gen_(std::move(engine)) {
+        std::vector<int> codes;
+        std::vector<std::uint64_t> counts;
+        for (const auto& pair : errorCodes) {
+            if (pair.second < 0) {
+                throw std::invalid_argument("Error: Negative count for error code '" + pair.first + "'.");
+            }
+            codes.push_back(parseErrorCode(pair.first));
+            counts.push_back(static_cast<std::uint64_t>(pair.second));
+        }
+        sampler_ = FenwickSampler(codes, counts);
+    }
+
+    // This function returns the next random error code.
+    int getNextErrorCode() {
+        return sampler_(gen_);
+    }
+
+    // This function fills a caller-provided buffer with the next count error codes.
+    void fill(int* out, std::size_t count) {
+        sampler_.fill(gen_, out, count);
+    }
+
+    void fill(std::vector<int>& out) {
+        fill(out.data(), out.size());
+    }
+
+    // This function adds delta (which may be negative) to the count of an error code; see
+    // FenwickSampler::increment(). The next draw already uses the new count.
+    void increment(int code, std::int64_t delta = 1) {
+        sampler_.increment(code, delta);
+    }
+
+    const FenwickSampler& sampler() const { return sampler_; }
+
+    Engine& engine() { return gen_; }
+
+private:
+    FenwickSampler sampler_;
+    Engine gen_;
+};
+
+using DynamicErrorCodeGenerator = BasicDynamicErrorCodeGenerator<>;
+
+#endif // DYNAMIC_ERROR_CODE_GENERATOR_H
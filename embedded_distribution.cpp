@@ -0,0 +1,164 @@
+// ==============================================
+// Description: Run-time distributions from embedded tables and the writer
+//              of the generated table header (see embedded_distribution.h)
+// ==============================================
+
+#include "embedded_distribution.h"
+#include "error_code_parser.h"
+
+#include <cctype>
+#include <limits>
+#include <set>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+// Turn a queue name into an identifier that is unique among those already taken.
+std::string enumerator(const std::string& queue, std::set<std::string>& taken) {
+    std::string name;
+    for (char c : queue) {
+        name += std::isalnum(static_cast<unsigned char>(c)) ? c : '_';
+    }
+    if (name.empty() || std::isdigit(static_cast<unsigned char>(name[0])) || name[0] == '_') {
+        name = "q" + name;
+    }
+    const std::string base = name;
+    for (int suffix = 2; !taken.insert(name).second; ++suffix) {
+        name = base + "_" + std::to_string(suffix);
+    }
+    return name;
+}
+
+// Escape a queue name for a C++ string literal.
+std::string literal(const std::string& text) {
+    std::string result = "\"";
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            result += '\\';
+        }
+        result += c;
+    }
+    return result + "\"";
+}
+
+template <class T>
+void list(std::ostream& out, const std::vector<T>& values) {
+    for (std::size_t i = 0; i < values.size(); ++i) {
+        out << (i == 0 ? "" : ", ") << values[i];
+    }
+}
+
+} // namespace
+
+
+std::shared_ptr<const ErrorCodeDistribution> embeddedDistribution(const EmbeddedQueueView& queue,
+                                                                  ErrorCodeDistribution::FillMode mode) {
+    std::vector<int> codes(queue.codes, queue.codes + queue.size);
+    std::vector<double> weights(queue.counts, queue.counts + queue.size);
+    if (queue.total == 0) {
+        // The columns are placeholders; the distribution is constant
+        return std::make_shared<const ErrorCodeDistribution>(std::move(codes), std::move(weights), AliasSampler(), mode);
+    }
+    AliasSampler sampler(std::vector<AliasSampler::Column>(queue.columns, queue.columns + queue.size));
+    return std::make_shared<const ErrorCodeDistribution>(std::move(codes), std::move(weights), std::move(sampler), mode);
+}
+
+void writeEmbeddedTables(const std::map<std::string, std::map<std::string, int>>& queues, std::ostream& out,
+                         const std::string& source) {
+    std::set<std::string> taken;
+    std::vector<std::string> enumerators;
+    for (const auto& pair : queues) {
+        enumerators.push_back(enumerator(pair.first, taken));
+    }
+
+    out << "// ==============================================\n"
+        << "// Description: Error code tables of " << queues.size() << " queues generated by\n"
+        << "//              error_code_compiler from " << source << ". Do not edit.\n"
+        << "// ==============================================\n\n"
+        << "#ifndef ERROR_CODE_TABLES_H\n"
+        << "#define ERROR_CODE_TABLES_H\n\n"
+        << "#include <cstddef>\n"
+        << "#include <cstdint>\n"
+        << "#include <memory>\n"
+        << "#include <optional>\n"
+        << "#include <string_view>\n"
+        << "#include \"embedded_distribution.h\"\n\n"
+        << "namespace error_code_tables {\n\n"
+        << "enum class Queue : std::uint32_t {\n";
+    for (const std::string& name : enumerators) {
+        out << "    " << name << ",\n";
+    }
+    out << "};\n\n"
+        << "constexpr std::size_t kQueueCount = " << queues.size() << ";\n\n"
+        << "template <Queue Q>\n"
+        << "struct Table;\n";
+
+    std::size_t q = 0;
+    for (const auto& [queue, codes] : queues) {
+        std::vector<int> queueCodes;
+        std::vector<double> weights;
+        std::vector<std::uint32_t> counts;
+        std::uint64_t total = 0;
+        for (const auto& [code, count] : codes) {
+            if (count < 0) {
+                throw std::runtime_error("Error: Negative count for error code '" + code + "' in " + queue + ".");
+            }
+            queueCodes.push_back(parseErrorCode(code, queue));
+            weights.push_back(count);
+            counts.push_back(static_cast<std::uint32_t>(count));
+            total += static_cast<std::uint64_t>(count);
+        }
+        std::vector<AliasSampler::Column> columns;
+        if (total > 0) {
+            columns = AliasSampler(queueCodes, weights).columns();
+        } else {
+            for (int code : queueCodes) {
+                columns.push_back({std::numeric_limits<std::uint64_t>::max(), code, code});
+            }
+        }
+
+        out << "\ntemplate <>\n"
+            << "struct Table<Queue::" << enumerators[q++] << "> {\n"
+            << "    static constexpr EmbeddedQueue<" << codes.size() << "> value{\n"
+            << "        " << literal(queue) << ", " << total << "ULL,\n"
+            << "        {{";
+        for (std::size_t i = 0; i < columns.size(); ++i) {
+            out << (i == 0 ? "" : ", ") << "{" << columns[i].threshold << "ULL, " << columns[i].code << ", "
+                << columns[i].alias << "}";
+        }
+        out << "}},\n"
+            << "        {{";
+        list(out, queueCodes);
+        out << "}},\n"
+            << "        {{";
+        list(out, counts);
+        out << "}}};\n"
+            << "};\n";
+    }
+
+    out << "\n// Views of all queues, in enum order\n"
+        << "inline constexpr EmbeddedQueueView kQueues[kQueueCount] = {\n";
+    for (const std::string& name : enumerators) {
+        out << "    Table<Queue::" << name << ">::value.view(),\n";
+    }
+    out << "};\n\n"
+        << "inline const EmbeddedQueueView& queue(Queue q) {\n"
+        << "    return kQueues[static_cast<std::size_t>(q)];\n"
+        << "}\n\n"
+        << "inline std::optional<Queue> findQueue(std::string_view name) {\n"
+        << "    const std::optional<std::size_t> index = findEmbeddedQueue(kQueues, kQueueCount, name);\n"
+        << "    return index ? std::optional<Queue>(static_cast<Queue>(*index)) : std::nullopt;\n"
+        << "}\n\n"
+        << "inline std::shared_ptr<const ErrorCodeDistribution> distribution(\n"
+        << "    Queue q, ErrorCodeDistribution::FillMode mode = ErrorCodeDistribution::FillMode::Auto) {\n"
+        << "    return embeddedDistribution(queue(q), mode);\n"
+        << "}\n\n"
+        << "template <Queue Q, class Engine = Xoshiro256StarStar>\n"
+        << "using Generator = BasicEmbeddedErrorCodeGenerator<Table<Q>, Engine>;\n\n"
+        << "} // namespace error_code_tables\n\n"
+        << "#endif // ERROR_CODE_TABLES_H\n";
+    if (!out) {
+        throw std::runtime_error("Error: Failed to write the embedded tables.");
+    }
+}
@@ -0,0 +1,163 @@
+// ==============================================
+// Description: Distribution tables compiled into the program. The
+//              error_code_compiler --header option turns error_codes.json
+//              into a header of constexpr per-queue tables and an enum of
+//              queues; this file holds the types that header uses and the
+//              samplers that run on them without any file I/O.
+// ==============================================
+
+#ifndef EMBEDDED_DISTRIBUTION_H
+#define EMBEDDED_DISTRIBUTION_H
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include "alias_sampler.h"
+#include "error_code_distribution.h"
+#include "random_engines.h"
+
+// Type-erased view of one embedded queue, for code that picks the queue at run time.
+struct EmbeddedQueueView {
+    std::string_view name;
+    const AliasSampler::Column* columns;
+    const int* codes;
+    const std::uint32_t* counts;
+    std::size_t size;
+    std::uint64_t total;
+};
+
+// The tables of one queue with K error codes: the counts in the order the tools use and the
+// alias table built from them exactly as at run time. total is the sum of the counts; if it
+// is 0 the columns are placeholders.
+template <std::size_t K>
+struct EmbeddedQueue {
+    std::string_view name;
+    std::uint64_t total;
+    std::array<AliasSampler::Column, K> columns;
+    std::array<int, K> codes;
+    std::array<std::uint32_t, K> counts;
+
+    static constexpr std::size_t size() { return K; }
+
+    constexpr EmbeddedQueueView view() const {
+        return {name, columns.data(), codes.data(), counts.data(), K, total};
+    }
+};
+
+// This function draws one error code of queue using the caller's engine. The table size is a
+// compile-time constant, so selecting the column is a multiply by a constant, and a queue
+// with a single code returns it without drawing a random number.
+template <std::size_t K, class URBG>
+int drawEmbedded(const EmbeddedQueue<K>& queue, URBG& gen) {
+    static_assert(K > 0, "cannot draw from a queue without error codes");
+    if constexpr (K == 1) {
+        return queue.codes[0];
+    } else {
+        static_assert(URBG::max() - URBG::min() == UINT64_MAX, "drawEmbedded needs a 64-bit engine");
+        const std::uint64_t x = static_cast<std::uint64_t>(gen() - URBG::min());
+        const unsigned __int128 m = static_cast<unsigned __int128>(x) * K;
+        const AliasSampler::Column& c = queue.columns[static_cast<std::size_t>(m >> 64)];
+        return static_cast<std::uint64_t>(m) < c.threshold ? c.code : c.alias;
+    }
+}
+
+// This function returns the code every draw of a degenerate queue yields, like
+// ErrorCodeDistribution::constantCode(): the success code 0 if the counts are all zero, or the
+// only code with a non-zero count. It returns std::nullopt for any other queue.
+template <std::size_t K>
+constexpr std::optional<int> embeddedConstantCode(const EmbeddedQueue<K>& queue) {
+    std::size_t positive = 0;
+    int code = 0;
+    for (std::size_t i = 0; i < K; ++i) {
+        if (queue.counts[i] > 0) {
+            ++positive;
+            code = queue.codes[i];
+        }
+    }
+    return positive <= 1 ? std::optional<int>(code) : std::nullopt;
+}
+
+// Generator for a queue chosen at compile time. Table is a class with a static constexpr
+// EmbeddedQueue member called value, e.g. error_code_tables::Table<Queue::AGLT2> from the
+// generated header. The draws are the same as those of ErrorCodeDistribution::draw with the
+// same engine state, and a degenerate queue compiles to its constant code.
+template <class Table, class Engine = Xoshiro256StarStar>
+class BasicEmbeddedErrorCodeGenerator {
+public:
+    using engine_type = Engine;
+
+    static constexpr const auto& queue = Table::value;
+    static constexpr std::optional<int> kConstantCode = embeddedConstantCode(queue);
+
+    explicit BasicEmbeddedErrorCodeGenerator(std::uint64_t seed = randomSeed()) : gen_(seed) {}
+    explicit BasicEmbeddedErrorCodeGenerator(Engine engine) : gen_(std::move(engine)) {}
+
+    // This function returns the next random error code.
+    int getNextErrorCode() {
+        if constexpr (kConstantCode.has_value()) {
+            return *kConstantCode;
+        } else {
+            return drawEmbedded(queue, gen_);
+        }
+    }
+
+    // This function fills a caller-provided buffer with the next count error codes.
+    void fill(int* out, std::size_t count) {
+        if constexpr (kConstantCode.has_value()) {
+            std::fill_n(out, count, *kConstantCode);
+        } else {
+            for (std::size_t i = 0; i < count; ++i) {
+                out[i] = drawEmbedded(queue, gen_);
+            }
+        }
+    }
+
+    Engine& engine() { return gen_; }
+
+private:
+    Engine gen_;
+};
+
+// This function returns the index of the queue called name in queues[0..count), which must be
+// sorted by name as in the generated header, or std::nullopt if there is none.
+inline std::optional<std::size_t> findEmbeddedQueue(const EmbeddedQueueView* queues, std::size_t count,
+                                                    std::string_view name) {
+    const EmbeddedQueueView* end = queues + count;
+    const EmbeddedQueueView* it = std::lower_bound(
+        queues, end, name, [](const EmbeddedQueueView& queue, std::string_view key) { return queue.name < key; });
+    if (it == end || it->name != name) {
+        return std::nullopt;
+    }
+    return static_cast<std::size_t>(it - queues);
+}
+
+// This function builds a distribution from embedded tables for use with ErrorCodeGenerator
+// and the other run-time generators; the alias table is copied, not rebuilt.
+std::shared_ptr<const ErrorCodeDistribution> embeddedDistribution(
+    const EmbeddedQueueView& queue, ErrorCodeDistribution::FillMode mode = ErrorCodeDistribution::FillMode::Auto);
+
+// This function writes the header of embedded tables for queues (queue name -> code string ->
+// count) to out. Its contents are placed in namespace error_code_tables:
+//
+//   enum class Queue           one enumerator per queue, named after the queue with every
+//                              character that cannot appear in an identifier replaced by '_'
+//   Table<Queue::X>::value     the constexpr EmbeddedQueue of queue X
+//   kQueues[kQueueCount]       views of all queues, in enum order (sorted by name)
+//   queue(q)                   the view of a queue
+//   findQueue(name)            the Queue called name, if any
+//   distribution(queue, mode)  embeddedDistribution() of a queue
+//   Generator<Queue::X>        BasicEmbeddedErrorCodeGenerator for queue X
+//
+// source is only mentioned in the header's banner. Throws std::invalid_argument for codes that
+// are not integers (see parseErrorCode()) and std::runtime_error for counts outside [0, 2^32).
+void writeEmbeddedTables(const std::map<std::string, std::map<std::string, int>>& queues, std::ostream& out,
+                         const std::string& source);
+
+#endif // EMBEDDED_DISTRIBUTION_H
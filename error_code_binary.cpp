@@ -0,0 +1,296 @@
+// ==============================================
+// Description: Writer and mmap-based reader for the binary distribution
+//              format described in error_code_binary.h
+// ==============================================
+
+#include "error_code_binary.h"
+#include "error_code_parser.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace error_code_binary {
+
+namespace {
+
+std::uint64_t align8(std::uint64_t offset) {
+    return (offset + 7) & ~std::uint64_t{7};
+}
+
+template <class T>
+void put(std::vector<unsigned char>& buffer, std::uint64_t offset, const T& value) {
+    std::memcpy(buffer.data() + offset, &value, sizeof(T));
+}
+
+} // namespace
+
+
+void write(const std::map<std::string, std::map<std::string, int>>& queues, std::ostream& out) {
+    if (queues.size() > std::numeric_limits<std::uint32_t>::max()) {
+        throw std::runtime_error("Error: Too many queues for the binary format.");
+    }
+
+    // Dense vocabulary of all distinct codes
+    std::vector<std::int32_t> vocabulary;
+    for (const auto& [queue, codes] : queues) {
+        for (const auto& pair : codes) {
+            vocabulary.push_back(parseErrorCode(pair.first, queue));
+        }
+    }
+    std::sort(vocabulary.begin(), vocabulary.end());
+    vocabulary.erase(std::unique(vocabulary.begin(), vocabulary.end()), vocabulary.end());
+
+    // Lay the file out: header, vocabulary, queue table, names, then the per-queue sections
+    Header header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.byteOrderMark = kByteOrderMark;
+    header.queueCount = static_cast<std::uint32_t>(queues.size());
+    header.vocabularySize = static_cast<std::uint32_t>(vocabulary.size());
+    header.vocabularyOffset = sizeof(Header);
+    header.queuesOffset = align8(header.vocabularyOffset + vocabulary.size() * sizeof(std::int32_t));
+    header.namesOffset = header.queuesOffset + queues.size() * sizeof(QueueEntry);
+
+    std::uint64_t namesSize = 0;
+    for (const auto& pair : queues) {
+        namesSize += pair.first.size();
+    }
+    if (namesSize > std::numeric_limits<std::uint32_t>::max()) {
+        throw std::runtime_error("Error: Queue names too long for the binary format.");
+    }
+
+    std::vector<QueueEntry> entries;
+    std::vector<std::vector<CodeCount>> counts;
+    std::vector<std::vector<AliasSampler::Column>> columns;
+    std::uint64_t offset = align8(header.namesOffset + namesSize);
+    std::uint32_t nameOffset = 0;
+    for (const auto& [queue, codes] : queues) {
+        QueueEntry entry{};
+        entry.nameOffset = nameOffset;
+        entry.nameLength = static_cast<std::uint32_t>(queue.size());
+        entry.codeCount = static_cast<std::uint32_t>(codes.size());
+        nameOffset += entry.nameLength;
+
+        std::vector<CodeCount> queueCounts;
+        std::vector<int> queueCodes;
+        std::vector<double> weights;
+        double total = 0.0;
+        for (const auto& [code, count] : codes) {
+            if (count < 0) {
+                throw std::runtime_error("Error: Negative count for error code '" + code + "' in " + queue + ".");
+            }
+            const int value = parseErrorCode(code, queue);
+            const auto index = std::lower_bound(vocabulary.begin(), vocabulary.end(), value) - vocabulary.begin();
+            queueCounts.push_back({static_cast<std::uint32_t>(index), static_cast<std::uint32_t>(count)});
+            queueCodes.push_back(value);
+            weights.push_back(count);
+            total += count;
+        }
+
+        entry.countsOffset = offset;
+        offset = align8(offset + queueCounts.size() * sizeof(CodeCount));
+        if (total > 0.0) {
+            columns.push_back(AliasSampler(queueCodes, weights).columns());
+            entry.columnsOffset = offset;
+            offset += columns.back().size() * sizeof(AliasSampler::Column);
+        } else {
+            // No alias table for a queue without any counts
+            columns.emplace_back();
+            entry.columnsOffset = 0;
+        }
+        entries.push_back(entry);
+        counts.push_back(std::move(queueCounts));
+    }
+    header.fileSize = offset;
+
+    // Serialize into one buffer and write it in one go
+    std::vector<unsigned char> buffer(static_cast<std::size_t>(header.fileSize), 0);
+    put(buffer, 0, header);
+    if (!vocabulary.empty()) {
+        std::memcpy(buffer.data() + header.vocabularyOffset, vocabulary.data(),
+                    vocabulary.size() * sizeof(std::int32_t));
+    }
+    std::uint64_t nameCursor = header.namesOffset;
+    std::size_t q = 0;
+    for (const auto& pair : queues) {
+        put(buffer, header.queuesOffset + q * sizeof(QueueEntry), entries[q]);
+        std::memcpy(buffer.data() + nameCursor, pair.first.data(), pair.first.size());
+        nameCursor += pair.first.size();
+        if (!counts[q].empty()) {
+            std::memcpy(buffer.data() + entries[q].countsOffset, counts[q].data(), counts[q].size() * sizeof(CodeCount));
+        }
+        if (!columns[q].empty()) {
+            std::memcpy(buffer.data() + entries[q].columnsOffset, columns[q].data(),
+                        columns[q].size() * sizeof(AliasSampler::Column));
+        }
+        ++q;
+    }
+    out.write(reinterpret_cast<const char*>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
+    if (!out) {
+        throw std::runtime_error("Error: Failed to write the binary file.");
+    }
+}
+
+
+bool isBinaryFile(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    char magic[sizeof(kMagic)] = {};
+    return file.read(magic, sizeof(magic)) && std::memcmp(magic, kMagic, sizeof(kMagic)) == 0;
+}
+
+
+MappedFile::MappedFile(const std::string& path) {
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Error: Could not open " + path);
+    }
+    struct stat st {};
+    if (::fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(Header))) {
+        ::close(fd);
+        throw std::runtime_error("Error: " + path + " is too small to be a binary error code file.");
+    }
+    size_ = static_cast<std::size_t>(st.st_size);
+    void* mapping = ::mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        throw std::runtime_error("Error: Could not map " + path);
+    }
+    data_ = static_cast<const unsigned char*>(mapping);
+
+    // Validate everything the accessors rely on, once
+    auto fail = [&](const std::string& reason) {
+        ::munmap(const_cast<unsigned char*>(data_), size_);
+        data_ = nullptr;
+        throw std::runtime_error("Error: " + path + ": " + reason);
+    };
+    auto inside = [&](std::uint64_t offset, std::uint64_t length) {
+        return offset <= size_ && length <= size_ - offset;
+    };
+    header_ = reinterpret_cast<const Header*>(data_);
+    if (std::memcmp(header_->magic, kMagic, sizeof(kMagic)) != 0) {
+        fail("not a binary error code file");
+    }
+    if (header_->byteOrderMark != kByteOrderMark) {
+        fail("written on a host with a different byte order");
+    }
+    if (header_->version != kVersion) {
+        fail("unsupported format version " + std::to_string(header_->version));
+    }
+    if (header_->fileSize != size_) {
+        fail("truncated file");
+    }
+    if (!inside(header_->vocabularyOffset, std::uint64_t{header_->vocabularySize} * sizeof(std::int32_t)) ||
+        header_->vocabularyOffset % alignof(std::int32_t) != 0 ||
+        !inside(header_->queuesOffset, std::uint64_t{header_->queueCount} * sizeof(QueueEntry)) ||
+        header_->queuesOffset % alignof(QueueEntry) != 0 || header_->namesOffset > size_) {
+        fail("corrupt header");
+    }
+    vocabulary_ = reinterpret_cast<const std::int32_t*>(data_ + header_->vocabularyOffset);
+    queues_ = reinterpret_cast<const QueueEntry*>(data_ + header_->queuesOffset);
+    names_ = reinterpret_cast<const char*>(data_ + header_->namesOffset);
+    for (std::size_t q = 0; q < header_->queueCount; ++q) {
+        const QueueEntry& e = queues_[q];
+        const bool ok = inside(header_->namesOffset + e.nameOffset, e.nameLength) &&
+                        inside(e.countsOffset, std::uint64_t{e.codeCount} * sizeof(CodeCount)) &&
+                        e.countsOffset % alignof(CodeCount) == 0 &&
+                        (e.columnsOffset == 0 ||
+                         (inside(e.columnsOffset, std::uint64_t{e.codeCount} * sizeof(AliasSampler::Column)) &&
+                          e.columnsOffset % alignof(AliasSampler::Column) == 0));
+        if (!ok) {
+            fail("corrupt entry for queue " + std::to_string(q));
+        }
+        const auto* queueCounts = reinterpret_cast<const CodeCount*>(data_ + e.countsOffset);
+        std::vector<std::int32_t> queueCodes(e.codeCount);
+        bool hasCounts = false;
+        for (std::size_t i = 0; i < e.codeCount; ++i) {
+            if (queueCounts[i].vocabularyIndex >= header_->vocabularySize) {
+                fail("corrupt counts for queue " + std::to_string(q));
+            }
+            queueCodes[i] = vocabulary_[queueCounts[i].vocabularyIndex];
+            hasCounts = hasCounts || queueCounts[i].count != 0;
+        }
+        // Only a queue whose counts are all zero may lack an alias table, and every column of
+        // the table must yield one of the queue's own codes
+        if (hasCounts && e.columnsOffset == 0) {
+            fail("missing alias table for queue " + std::to_string(q));
+        }
+        if (e.columnsOffset != 0) {
+            std::sort(queueCodes.begin(), queueCodes.end());
+            auto known = [&](int code) { return std::binary_search(queueCodes.begin(), queueCodes.end(), code); };
+            const auto* columns = reinterpret_cast<const AliasSampler::Column*>(data_ + e.columnsOffset);
+            for (std::size_t i = 0; i < e.codeCount; ++i) {
+                if (!known(columns[i].code) || !known(columns[i].alias)) {
+                    fail("corrupt alias table for queue " + std::to_string(q));
+                }
+            }
+        }
+    }
+}
+
+MappedFile::~MappedFile() {
+    if (data_ != nullptr) {
+        ::munmap(const_cast<unsigned char*>(data_), size_);
+    }
+}
+
+std::string_view MappedFile::queueName(std::size_t queue) const {
+    const QueueEntry& e = entry(queue);
+    return std::string_view(names_ + e.nameOffset, e.nameLength);
+}
+
+std::optional<std::size_t> MappedFile::findQueue(std::string_view name) const {
+    std::size_t lo = 0;
+    std::size_t hi = queueCount();
+    while (lo < hi) {
+        const std::size_t mid = lo + (hi - lo) / 2;
+        const int cmp = queueName(mid).compare(name);
+        if (cmp == 0) {
+            return mid;
+        }
+        if (cmp < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return std::nullopt;
+}
+
+std::map<std::string, int> MappedFile::errorCodes(std::size_t queue) const {
+    const QueueEntry& e = entry(queue);
+    const auto* queueCounts = reinterpret_cast<const CodeCount*>(data_ + e.countsOffset);
+    std::map<std::string, int> result;
+    for (std::size_t i = 0; i < e.codeCount; ++i) {
+        result[std::to_string(vocabulary_[queueCounts[i].vocabularyIndex])] = static_cast<int>(queueCounts[i].count);
+    }
+    return result;
+}
+
+std::shared_ptr<const ErrorCodeDistribution> MappedFile::distribution(std::size_t queue,
+                                                                     ErrorCodeDistribution::FillMode mode) const {
+    const QueueEntry& e = entry(queue);
+    const auto* queueCounts = reinterpret_cast<const CodeCount*>(data_ + e.countsOffset);
+    std::vector<int> codes(e.codeCount);
+    std::vector<double> weights(e.codeCount);
+    for (std::size_t i = 0; i < e.codeCount; ++i) {
+        codes[i] = vocabulary_[queueCounts[i].vocabularyIndex];
+        weights[i] = queueCounts[i].count;
+    }
+    if (e.columnsOffset == 0) {
+        // No stored table: the counts are all zero, which makes the queue constant
+        return std::make_shared<const ErrorCodeDistribution>(std::move(codes), std::move(weights), AliasSampler(), mode);
+    }
+    const auto* first = reinterpret_cast<const AliasSampler::Column*>(data_ + e.columnsOffset);
+    AliasSampler sampler(std::vector<AliasSampler::Column>(first, first + e.codeCount));
+    return std::make_shared<const ErrorCodeDistribution>(std::move(codes), std::move(weights), std::move(sampler), mode);
+}
+
+} // namespace error_code_binary
@@ -0,0 +1,118 @@
+// ==============================================
+// Description: Versioned binary distribution format for error_codes.json.
+//              The file holds a sorted queue name table, the dense int
+//              vocabulary of all error codes and, per queue, the counts and
+//              the precomputed alias table. It is read through a read-only
+//              mmap, so every process on a node shares one page-cache copy.
+// ==============================================
+
+#ifndef ERROR_CODE_BINARY_H
+#define ERROR_CODE_BINARY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include "alias_sampler.h"
+#include "error_code_distribution.h"
+
+namespace error_code_binary {
+
+// File layout (all offsets are from the start of the file, all values in host byte order,
+// which the byte order mark pins to little-endian in practice):
+//
+//   Header
+//   int32_t    vocabulary[vocabularySize]     sorted distinct error codes
+//   QueueEntry queues[queueCount]             sorted by name
+//   char       names[]                        queue names, not NUL-terminated
+//   per queue, 8-byte aligned:
+//     CodeCount            counts[codeCount]  in the code order used by the tools
+//     AliasSampler::Column columns[codeCount] absent (offset 0) if all counts are zero
+constexpr char kMagic[8] = {'R', 'N', 'D', 'E', 'R', 'R', 'B', 'N'};
+constexpr std::uint32_t kVersion = 1;
+constexpr std::uint32_t kByteOrderMark = 0x01020304;
+
+struct Header {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t byteOrderMark;
+    std::uint32_t queueCount;
+    std::uint32_t vocabularySize;
+    std::uint64_t vocabularyOffset;
+    std::uint64_t queuesOffset;
+    std::uint64_t namesOffset;
+    std::uint64_t fileSize;
+};
+
+struct QueueEntry {
+    std::uint32_t nameOffset; // relative to Header::namesOffset
+    std::uint32_t nameLength;
+    std::uint32_t codeCount;
+    std::uint32_t reserved;
+    std::uint64_t countsOffset;
+    std::uint64_t columnsOffset;
+};
+
+struct CodeCount {
+    std::uint32_t vocabularyIndex;
+    std::uint32_t count;
+};
+
+static_assert(sizeof(Header) == 56, "unexpected padding in Header");
+static_assert(sizeof(QueueEntry) == 32, "unexpected padding in QueueEntry");
+static_assert(sizeof(AliasSampler::Column) == 16, "unexpected padding in AliasSampler::Column");
+
+// This function writes the binary form of queues (queue name -> code string -> count) to out.
+// Throws std::invalid_argument for codes that are not integers (see parseErrorCode()) and
+// std::runtime_error for counts outside [0, 2^32).
+void write(const std::map<std::string, std::map<std::string, int>>& queues, std::ostream& out);
+
+// This function reports whether the file at path starts with the binary format's magic.
+bool isBinaryFile(const std::string& path);
+
+
+// Read-only memory mapping of a binary distribution file.
+class MappedFile {
+public:
+    // Map and validate the file. Throws std::runtime_error if it cannot be opened or mapped,
+    // or if it is not a well-formed file of this version.
+    explicit MappedFile(const std::string& path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    std::size_t queueCount() const { return header_->queueCount; }
+    std::string_view queueName(std::size_t queue) const;
+
+    // This function looks a queue up by name with a binary search over the sorted table.
+    std::optional<std::size_t> findQueue(std::string_view name) const;
+
+    // The queue's counts keyed by code string, as loadQueue() would return them.
+    std::map<std::string, int> errorCodes(std::size_t queue) const;
+
+    // A distribution built straight from the stored tables, without any parsing.
+    std::shared_ptr<const ErrorCodeDistribution> distribution(
+        std::size_t queue, ErrorCodeDistribution::FillMode mode = ErrorCodeDistribution::FillMode::Auto) const;
+
+    const std::int32_t* vocabulary() const { return vocabulary_; }
+    std::size_t vocabularySize() const { return header_->vocabularySize; }
+
+private:
+    const QueueEntry& entry(std::size_t queue) const { return queues_[queue]; }
+
+    const unsigned char* data_{nullptr};
+    std::size_t size_{0};
+    const Header* header_{nullptr};
+    const std::int32_t* vocabulary_{nullptr};
+    const QueueEntry* queues_{nullptr};
+    const char* names_{nullptr};
+};
+
+} // namespace error_code_binary
+
+#endif // ERROR_CODE_BINARY_H
@@ -0,0 +1,77 @@
+// ==============================================
+// Description: Compile error_codes.json into the binary distribution
+//              format (see error_code_binary.h) or into a header of
+//              embedded tables (see embedded_distribution.h)
+// ==============================================
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include "command_line.h"
+#include "embedded_distribution.h"
+#include "error_code_binary.h"
+#include "error_code_loader.h"
+
+
+int main(int argc, char* argv[]) {
+
+    if (argc < 5) {
+        std::cerr << "Usage: " << argv[0] << " --input <input file> --output <binary file>" << std::endl;
+        std::cerr << "       " << argv[0] << " --input <input file> --header <header file>" << std::endl;
+        return 1;
+    }
+
+    std::string input_file{""};
+    std::string output_file{""};
+    bool header{false};
+    try {
+        const Arguments arguments = parseArguments(argc, argv, {"--input"});
+        if (arguments.output_file.empty() == arguments.header_file.empty()) {
+            throw std::runtime_error("Error: Exactly one of --output and --header must be given.");
+        }
+        input_file = arguments.input_file;
+        header = !arguments.header_file.empty();
+        output_file = header ? arguments.header_file : arguments.output_file;
+        std::cout << "Input File: " << input_file << std::endl;
+        std::cout << "Output File: " << output_file << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // Read every queue of the JSON file
+    std::map<std::string, std::map<std::string, int>> dictionary;
+    std::size_t codeCount = 0;
+    try {
+        dictionary = loadAllQueues(input_file);
+        for (const auto& pair : dictionary) {
+            codeCount += pair.second.size();
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::ofstream out(output_file, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+        std::cerr << "Error: Could not create " << output_file << std::endl;
+        return EXIT_FAILURE;
+    }
+    try {
+        if (header) {
+            // Name only the file in the banner, so that the header does not depend on the build directory
+            writeEmbeddedTables(dictionary, out, input_file.substr(input_file.find_last_of('/') + 1));
+        } else {
+            error_code_binary::write(dictionary, out);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::cout << "Compiled " << dictionary.size() << " queues with " << codeCount << " error code counts." << std::endl;
+    return EXIT_SUCCESS;
+}
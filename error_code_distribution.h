@@ -0,0 +1,192 @@
+// ==============================================
+// Description: Immutable sampling tables for one queue, shared between any
+//              number of generators (one per thread or per stream)
+// ==============================================
+
+#ifndef ERROR_CODE_DISTRIBUTION_H
+#define ERROR_CODE_DISTRIBUTION_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "alias_sampler.h"
+#include "error_code_parser.h"
+#include "exact_sampler.h"
+#include "simd_alias_kernel.h"
+#include "skip_sampler.h"
+
+class ErrorCodeDistribution {
+public:
+    // How fill() produces its codes. Auto uses the skip-ahead sampler when successes make up
+    // at least kSkipAheadThreshold of the queue and the vectorized alias kernel otherwise.
+    // The vectorized kernel is roughly as fast as skip-ahead at a 2% failure rate. Single draws
+    // in Auto mode come from the ExactSampler when its SIMD search applies (integer counts, at
+    // most ExactSampler::kSmallSize codes), which beats the alias table for every such queue,
+    // and from the alias table otherwise. Exact makes draw() and fill() use the ExactSampler,
+    // which reproduces the integer counts exactly instead of up to the rounding of the alias
+    // thresholds; it needs integer weights.
+    // Constant is chosen whatever the requested mode for a degenerate queue: one whose
+    // counts are all zero, which always yields the success code 0, or one where a single code
+    // has all of the counts. Its draws and fills return that code without any random numbers.
+    enum class FillMode { Auto, Alias, SkipAhead, Vector, Exact, Constant };
+    static constexpr double kSkipAheadThreshold = 0.98;
+
+    // The constructor parses the error codes once and builds the alias tables. errorCodes is
+    // any range of (code string, count) pairs, e.g. a std::map<std::string, int>. Throws
+    // std::invalid_argument if a code is not an integer (see parseErrorCode()).
+    template <class ErrorCodes>
+    explicit ErrorCodeDistribution(const ErrorCodes& errorCodes, FillMode mode = FillMode::Auto) {
+        // Build flat code and weight vectors from the error codes
+        for (const auto& pair : errorCodes) {
+            codes_.push_back(parseErrorCode(pair.first));
+            weights_.push_back(pair.second);
+        }
+        // A constant queue (see FillMode) needs no alias table
+        if (std::count_if(weights_.begin(), weights_.end(), [](double w) { return w > 0.0; }) >= 2) {
+            sampler_ = AliasSampler(codes_, weights_);
+        }
+        initialize(mode);
+    }
+
+    // This constructor takes already parsed codes and weights together with the alias table
+    // built from them, e.g. from a precompiled binary file. The table may be empty if the
+    // queue is constant, i.e. fewer than two weights are positive.
+    ErrorCodeDistribution(std::vector<int> codes, std::vector<double> weights, AliasSampler sampler,
+                          FillMode mode = FillMode::Auto)
+        : codes_(std::move(codes)), weights_(std::move(weights)), sampler_(std::move(sampler)) {
+        initialize(mode);
+    }
+
+    // This function draws one error code using the caller's engine.
+    template <class URBG>
+    int draw(URBG& gen) const {
+        if (mode_ == FillMode::Constant) {
+            return constantCode_;
+        }
+        return exactDraws_ ? exactSampler_(gen) : sampler_(gen);
+    }
+
+    // This function draws the next failure and the number of successes before it.
+    template <class URBG>
+    SkipSampler::Failure nextFailure(URBG& gen) const {
+        if (mode_ == FillMode::Constant) {
+            return constantCode_ == SkipSampler::kSuccessCode ? SkipSampler::Failure{UINT64_MAX, constantCode_}
+                                                              : SkipSampler::Failure{0, constantCode_};
+        }
+        return skipSampler_.nextFailure(gen);
+    }
+
+    // This function fills out[0..count) with error codes using the caller's engine. In Vector
+    // mode the kernel lanes are seeded from the engine at the start of every fill, so the
+    // result depends only on the engine state and not on the CPU the kernel runs on.
+    template <class URBG>
+    void fill(URBG& gen, int* out, std::size_t count) const {
+        if (mode_ == FillMode::Constant) {
+            std::fill_n(out, count, constantCode_);
+        } else if (mode_ == FillMode::SkipAhead) {
+            skipSampler_.fill(gen, out, count);
+        } else if (mode_ == FillMode::Exact) {
+            exactSampler_.fill(gen, out, count);
+        } else if (mode_ == FillMode::Vector && count >= SimdAliasKernel::kMinCount) {
+            SimdAliasKernel::Lanes lanes;
+            lanes.seed(gen);
+            vectorKernel_.fill(lanes, out, count);
+        } else {
+            sampler_.fill(gen, out, count);
+        }
+    }
+
+    FillMode fillMode() const { return mode_; }
+
+    // Whether every draw returns constantCode(), and whether that is because the counts are
+    // all zero
+    bool isConstant() const { return mode_ == FillMode::Constant; }
+    // Whether draw() uses the ExactSampler: always in Exact mode, and for small queues in Auto
+    bool exactDraws() const { return exactDraws_; }
+    bool hasCounts() const { return hasCounts_; }
+    int constantCode() const { return constantCode_; }
+
+    const std::vector<int>& codes() const { return codes_; }
+    const std::vector<double>& weights() const { return weights_; }
+
+    const AliasSampler& aliasSampler() const { return sampler_; }
+
+private:
+    // Build the derived samplers and resolve FillMode::Auto.
+    void initialize(FillMode mode) {
+        if (codes_.empty() || codes_.size() != weights_.size()) {
+            throw std::invalid_argument("Error: AliasSampler needs one weight per error code.");
+        }
+        // Degenerate queues need no tables at all
+        std::size_t positive = 0;
+        for (std::size_t i = 0; i < codes_.size(); ++i) {
+            if (weights_[i] < 0.0) {
+                throw std::invalid_argument("Error: AliasSampler weights must be non-negative.");
+            }
+            if (weights_[i] > 0.0) {
+                ++positive;
+                constantCode_ = codes_[i];
+            }
+        }
+        hasCounts_ = positive != 0;
+        if (positive <= 1) {
+            if (!hasCounts_) {
+                constantCode_ = SkipSampler::kSuccessCode;
+            }
+            mode_ = FillMode::Constant;
+            return;
+        }
+        if (mode == FillMode::Constant) {
+            throw std::invalid_argument("Error: Constant mode needs a queue with a single error code.");
+        }
+        skipSampler_ = SkipSampler(codes_, weights_);
+        vectorKernel_ = SimdAliasKernel(sampler_);
+        if (mode == FillMode::Exact) {
+            if (!buildExactSampler()) {
+                throw std::invalid_argument("Error: Exact sampling needs integer counts.");
+            }
+            exactDraws_ = true;
+        }
+        if (mode == FillMode::Auto) {
+            const double successFraction = 1.0 - skipSampler_.failureProbability();
+            mode = successFraction >= kSkipAheadThreshold ? FillMode::SkipAhead : FillMode::Vector;
+            // A single draw from a small queue takes about half the time with the SIMD search
+            // (3.6 ns against 6.7 ns on praguelcg2), as the alias table's keep-or-alias branch
+            // mispredicts; bulk fills stay with the faster vector and skip-ahead kernels
+            exactDraws_ = codes_.size() <= ExactSampler::kSmallSize &&
+                          std::accumulate(weights_.begin(), weights_.end(), 0.0) <= UINT32_MAX && buildExactSampler();
+        }
+        mode_ = mode;
+    }
+
+    // Build the ExactSampler from the weights. Returns false if they are not all integer counts.
+    bool buildExactSampler() {
+        std::vector<std::uint64_t> counts;
+        for (double w : weights_) {
+            if (w != std::floor(w) || w >= 18446744073709551616.0) {
+                return false;
+            }
+            counts.push_back(static_cast<std::uint64_t>(w));
+        }
+        exactSampler_ = ExactSampler(codes_, counts);
+        return true;
+    }
+
+    std::vector<int> codes_;
+    std::vector<double> weights_;
+    AliasSampler sampler_;
+    SkipSampler skipSampler_;
+    SimdAliasKernel vectorKernel_;
+    ExactSampler exactSampler_;
+    FillMode mode_{FillMode::Alias};
+    int constantCode_{SkipSampler::kSuccessCode};
+    bool hasCounts_{false};
+    bool exactDraws_{false};
+};
+
+#endif // ERROR_CODE_DISTRIBUTION_H
@@ -1,91 +1,183 @@
+#include <cstdint>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
 #include <cstdlib>
 #include <iostream>
-#include <fstream>
-#include <map>
-#include <random>
-#include <iterator>
+#include <memory>
+#include <optional>
 #include <string>
-#include <stdexcept>
-#include <unordered_map>
-#include <utility> // for std::pair
 #include <vector>
-#include <nlohmann/json.hpp>
+#include "allocation_counter.h"
+#include "code_writer.h"
+#include "command_line.h"
+#include "random_errors.h"
+#include "shared_ring.h"
+#include "socket_service.h"
 
 // using namespace std;
-using json = nlohmann::json;
-
-class ErrorCodeGenerator {
-public:
-    // The constructor initializes the weights and the discrete distribution.
-    ErrorCodeGenerator(const std::map<std::string, int>& errorCodes)
-        : errorCodes_(errorCodes), gen_(std::random_device{}())
-    {
-        // Build the weights vector from the error codes
-        for (const auto& pair : errorCodes_) {
-            weights_.push_back(pair.second);
-        }
-        dist_ = std::discrete_distribution<>(weights_.begin(), weights_.end());
+
+// Function to generate the requested number of error codes with the given engine
+template <class Engine>
+void generateErrorCodes(const std::shared_ptr<const ErrorCodeDistribution>& distribution, const Arguments& arguments) {
+    // Blocks of BasicParallelGenerator::kBlockSize codes are generated and consumed one at a
+    // time per thread, so memory use does not depend on n
+    BasicParallelGenerator<Engine> generator(distribution, arguments.seed, arguments.threads);
+    std::unique_ptr<ProgressReporter> progress;
+    if (arguments.progress) {
+        progress = std::make_unique<ProgressReporter>(arguments.n, std::cerr);
     }
-    
-    // This function returns the next random error code.
-    int getNextErrorCode() {
-        // Generate a random index based on the weights
-        int randomIndex = dist_(gen_);
-        // Get the corresponding error code from the map.
-        auto it = std::next(errorCodes_.cbegin(), randomIndex);
-        try {
-            // Convert the error code string to int.
-            return std::stoi(it->first);
-        } catch (const std::invalid_argument& e) {
-            std::cout << "Error: '" << it->first << "' is not a valid integer error code." << std::endl;
-            return -1; // or handle the error appropriately
+    generator.generate(arguments.n, [&](unsigned, std::uint64_t, const int*, std::size_t size) {
+        if (progress) {
+            progress->advance(size);
         }
-    }
-    
-private:
-    std::map<std::string, int> errorCodes_;
-    std::vector<double> weights_;
-    std::mt19937 gen_;
-    std::discrete_distribution<> dist_;
-};
-
-
-// Function to parse command-line arguments
-std::tuple<std::string, int, std::string> parseArguments(int argc, char* argv[]) {
-    std::unordered_map<std::string, std::string> args;
-
-    // Parse command-line arguments
-    for (int i = 1; i < argc - 1; i++) {
-        std::string key = argv[i];
-        std::string value = argv[i + 1];
-        if (key == "--input" || key == "--n" || key == "--queue") {
-            args[key] = value;
-            i++; // Skip next as it's a value
+    });
+}
+
+// Function to generate the requested number of error codes and stream them to --output in
+// sequence order. Consecutive pieces of a few blocks per thread are generated in parallel and
+// then written, so memory use is bounded and the codes are the same as above. With
+// --checkpoint, the position reached and the bytes written so far are saved about once per
+// second and at the end, together with --n and --format; resumeFrom, read from such a
+// checkpoint, continues the run there if both are the same. The time spent writing, flushing
+// and checkpointing is recorded as the "output" phase of stats, the rest as "draw".
+template <class Engine>
+void writeErrorCodes(const std::shared_ptr<const ErrorCodeDistribution>& distribution, const Arguments& arguments,
+                     const generator_checkpoint::State* resumeFrom, RunStats& stats) {
+    BasicParallelGenerator<Engine> generator(distribution, arguments.seed, arguments.threads);
+    std::uint64_t first = 0;
+    std::unique_ptr<CodeWriter> writer;
+    if (resumeFrom) {
+        generator_checkpoint::verify(*resumeFrom, generator_checkpoint::Kind::Parallel, engineName<Engine>(),
+                                     *distribution);
+        // Another --n or --format would not continue the same output
+        if (resumeFrom->total != arguments.n) {
+            throw std::runtime_error("Error: The checkpoint is of a run with --n " + std::to_string(resumeFrom->total) +
+                                     ", not " + std::to_string(arguments.n) + ".");
         }
+        if (resumeFrom->outputFormat != arguments.output_format) {
+            throw std::runtime_error("Error: The checkpoint is of a run with --format " + resumeFrom->outputFormat +
+                                     ", not " + arguments.output_format + ".");
+        }
+        first = resumeFrom->position;
+        writer = std::make_unique<CodeWriter>(arguments.output_file, CodeWriter::parseFormat(arguments.output_format),
+                                              resumeFrom->outputBytes);
+    } else {
+        writer = std::make_unique<CodeWriter>(arguments.output_file, CodeWriter::parseFormat(arguments.output_format));
     }
-
-    // Extract values with validation
-    if (args.find("--input") == args.end()) {
-        throw std::runtime_error("Error: Missing --input argument.");
+    std::unique_ptr<ProgressReporter> progress;
+    if (arguments.progress) {
+        progress = std::make_unique<ProgressReporter>(arguments.n - first, std::cerr);
+    }
+    const std::uint64_t piece = std::uint64_t{BasicParallelGenerator<Engine>::kBlockSize} * generator.threads() * 4;
+    std::vector<int> buffer(static_cast<std::size_t>(std::min(arguments.n - first, piece)));
+    auto saveCheckpoint = [&](std::uint64_t position) {
+        generator_checkpoint::State state = generator.checkpointState(position);
+        state.total = arguments.n;
+        state.outputFormat = arguments.output_format;
+        state.outputBytes = writer->bytesWritten();
+        generator_checkpoint::save(arguments.checkpoint_file, generator_checkpoint::serialize(state));
+    };
+    auto nextCheckpoint = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+    for (std::uint64_t offset = first; offset < arguments.n; offset += buffer.size()) {
+        const std::size_t size = static_cast<std::size_t>(std::min<std::uint64_t>(buffer.size(), arguments.n - offset));
+        stats.phase("draw");
+        generator.fill(buffer.data(), offset, size);
+        stats.phase("output");
+        writer->write(buffer.data(), size);
+        if (progress) {
+            progress->advance(size);
+        }
+        if (!arguments.checkpoint_file.empty() && std::chrono::steady_clock::now() >= nextCheckpoint) {
+            // The codes must be in the file before the checkpoint says so
+            writer->flush();
+            saveCheckpoint(offset + size);
+            nextCheckpoint = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+        }
     }
-    if (args.find("--n") == args.end()) {
-        throw std::runtime_error("Error: Missing --n argument.");
+    stats.phase("output");
+    writer->close();
+    if (!arguments.checkpoint_file.empty()) {
+        saveCheckpoint(arguments.n);
     }
-    if (args.find("--queue") == args.end()) {
-        throw std::runtime_error("Error: Missing --queue argument.");
+}
+
+// Function to tell the user that a queue needs no random draws at all
+void reportConstantQueue(std::ostream& out, const std::string& queue, const ErrorCodeDistribution& distribution) {
+    if (distribution.isConstant()) {
+        out << "Queue " << queue << " is constant: every code is " << distribution.constantCode()
+            << (distribution.hasCounts() ? "" : " (all counts are zero)") << std::endl;
     }
+}
 
-    std::string input_file = args["--input"];
-    std::string queue_name = args["--queue"];
-    int n;
+// Set by SIGINT and SIGTERM to stop the producer and the server
+std::atomic<bool> stopRequested{false};
 
+// Function to keep shared-memory rings of pre-generated codes full until the process is
+// interrupted. --queue may list several queues separated by commas; without it every queue of
+// the input file is served.
+int produceErrorCodes(const Arguments& arguments) {
     try {
-        n = std::stoi(args["--n"]);
-    } catch (...) {
-        throw std::runtime_error("Error: Invalid value for --n. It must be an integer.");
+        GeneratorRegistry registry(arguments.input_file, arguments.seed);
+        std::vector<GeneratorRegistry::QueueHandle> queues;
+        if (arguments.queue_name.empty()) {
+            for (std::uint32_t q = 0; q < registry.size(); ++q) {
+                queues.push_back({q});
+            }
+        } else {
+            std::size_t start = 0;
+            while (start <= arguments.queue_name.size()) {
+                std::size_t end = arguments.queue_name.find(',', start);
+                if (end == std::string::npos) {
+                    end = arguments.queue_name.size();
+                }
+                queues.push_back(registry.handle(arguments.queue_name.substr(start, end - start)));
+                start = end + 1;
+            }
+        }
+
+        shared_ring::Producer producer(arguments.produce_name, registry, queues, arguments.slots, arguments.batch);
+        for (GeneratorRegistry::QueueHandle queue : queues) {
+            reportConstantQueue(std::cout, registry.name(queue), *registry.distribution(queue));
+        }
+        std::cout << "Serving " << queues.size() << " queues in shared memory " << arguments.produce_name << " ("
+                  << producer.size() << " bytes, " << arguments.slots << " batches of " << arguments.batch
+                  << " codes per queue)" << std::endl;
+        std::signal(SIGINT, [](int) { stopRequested = true; });
+        std::signal(SIGTERM, [](int) { stopRequested = true; });
+        producer.run(stopRequested);
+        std::cout << "Produced " << producer.batchesProduced() << " batches." << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
     }
+    return EXIT_SUCCESS;
+}
+
+// Function to answer draw requests on a Unix domain socket until the process is interrupted.
+// Every queue of the input file is built up front so that no request waits for it.
+int serveErrorCodes(const Arguments& arguments) {
+    try {
+        GeneratorRegistry registry(arguments.input_file, arguments.seed);
+        std::uint32_t constant = 0;
+        for (std::uint32_t q = 0; q < registry.size(); ++q) {
+            registry.generator(GeneratorRegistry::QueueHandle{q});
+            constant += registry.distribution(GeneratorRegistry::QueueHandle{q})->isConstant() ? 1 : 0;
+        }
 
-    return {input_file, n, queue_name};
+        socket_service::Server server(arguments.serve_path, registry);
+        std::cout << "Serving " << registry.size() << " queues on " << arguments.serve_path << " (" << constant
+                  << " of them constant)" << std::endl;
+        std::signal(SIGINT, [](int) { stopRequested = true; });
+        std::signal(SIGTERM, [](int) { stopRequested = true; });
+        server.run(stopRequested);
+        std::cout << "Served " << server.requestsServed() << " requests." << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
 }
 
 
@@ -93,63 +185,118 @@ int main(int argc, char* argv[]) {
 
         // Read input file from arguments --input
     if (argc < 5) {
-        std::cerr << "Usage: " << argv[0] << " --input <input file> --queue <queue name>  --n <number of errors>" << std::endl;
+        std::cerr << "Usage: " << argv[0] << " --input <input file> --queue <queue name>  --n <number of errors> [--exact] [--threads <N>] [--seed <seed>] [--engine xoshiro256|pcg64|philox|mt19937] [--stats[=json]] [--progress] [--output <file>|- [--format int16|int32|varint|text] [--checkpoint <file> [--resume]]]" << std::endl;
+        std::cerr << "       " << argv[0] << " --input <input file> --produce <shared memory name> [--queue <queue>[,<queue>...]] [--slots <N>] [--batch <codes>] [--seed <seed>]" << std::endl;
+        std::cerr << "       " << argv[0] << " --input <input file> --serve <socket path> [--seed <seed>]" << std::endl;
         return 1;
     }
 
-    std::string input_file{""};
-    std::string queue_name{""};
-    int n{0};
+    Arguments arguments;
     try {
-        // Assign values from function
-        std::tie(input_file, n, queue_name) = parseArguments(argc, argv);
-        std::cout << "Input File: " << input_file << std::endl;
-        std::cout << "Number of errors: " << n << std::endl;
-        std::cout << "Queue Name: " << queue_name << std::endl;
+        // Assign values from function. Producer and server modes run until interrupted and need no --n.
+        const bool producing = std::find(argv + 1, argv + argc, std::string("--produce")) != argv + argc;
+        const bool serving = std::find(argv + 1, argv + argc, std::string("--serve")) != argv + argc;
+        arguments = producing ? parseArguments(argc, argv, {"--input", "--produce"})
+                    : serving ? parseArguments(argc, argv, {"--input", "--serve"})
+                              : parseArguments(argc, argv);
     } catch (const std::exception& e) {
         std::cerr << e.what() << std::endl;
         return EXIT_FAILURE;
     }
-
-    // Read error codes from JSON file using the input argument
-    std::ifstream file(input_file);
-    if (!file.is_open()) {
-        std::cerr << "Error: Could not open " << input_file << std::endl;
-        return EXIT_FAILURE;
+    if (!arguments.produce_name.empty()) {
+        std::cout << "Input File: " << arguments.input_file << std::endl;
+        std::cout << "Seed: " << arguments.seed << std::endl;
+        return produceErrorCodes(arguments);
+    }
+    if (!arguments.serve_path.empty()) {
+        std::cout << "Input File: " << arguments.input_file << std::endl;
+        std::cout << "Seed: " << arguments.seed << std::endl;
+        return serveErrorCodes(arguments);
     }
-    json j;
-    file >> j;
-    if (!file) {
-        std::cerr << "Error: Failed to parse " << input_file << std::endl;
+    // A resumed run takes its seed and engine from the checkpoint
+    std::optional<generator_checkpoint::State> resumeFrom;
+    try {
+        if (!arguments.checkpoint_file.empty() && (arguments.output_file.empty() || arguments.output_file == "-")) {
+            throw std::runtime_error("Error: --checkpoint needs --output <file>.");
+        }
+        if (arguments.resume) {
+            const std::vector<unsigned char> checkpoint = generator_checkpoint::load(arguments.checkpoint_file);
+            resumeFrom = generator_checkpoint::deserialize(checkpoint.data(), checkpoint.size());
+            if (!isEngineName(resumeFrom->engine)) {
+                throw std::runtime_error("Error: Unknown engine '" + resumeFrom->engine + "' in the checkpoint.");
+            }
+            arguments.seed = resumeFrom->seed;
+            arguments.engine = resumeFrom->engine;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
         return EXIT_FAILURE;
     }
+    // When the codes go to stdout, everything else goes to stderr
+    std::ostream& info = arguments.output_file == "-" ? std::cerr : std::cout;
+    info << "Input File: " << arguments.input_file << std::endl;
+    info << "Number of errors: " << arguments.n << std::endl;
+    info << "Queue Name: " << arguments.queue_name << std::endl;
+    info << "Threads: " << arguments.threads << std::endl;
+    info << "Seed: " << arguments.seed << std::endl;
+    info << "Engine: " << arguments.engine << std::endl;
+    info << "Vector kernel: " << SimdAliasKernel::isa() << std::endl;
+    if (!arguments.output_file.empty()) {
+        info << "Output: " << arguments.output_file << " (" << arguments.output_format << ")" << std::endl;
+    }
+    if (resumeFrom) {
+        info << "Resuming at: " << resumeFrom->position << " (" << arguments.checkpoint_file << ")" << std::endl;
+    }
+    const std::string& input_file = arguments.input_file;
+    const std::string& queue_name = arguments.queue_name;
 
-    // Populate the dictionary with the error codes
-    std::map<std::string, std::map<std::string, int>> dictionary;
-    for (const auto& [site_name, codes] : j.items()) {
-        for (const auto& [code, count] : codes.items()) {
-            dictionary[site_name][code] = count;
+    // Load the target queue and build the distribution once; every generator and worker thread
+    // shares its tables. A JSON file is streamed and only the target queue is kept; a compiled
+    // binary file is memory-mapped and its alias tables are used as they are.
+    RunStats stats;
+    std::shared_ptr<const ErrorCodeDistribution> distribution;
+    try {
+        distribution = loadDistribution(input_file, queue_name,
+                                        arguments.exact ? ErrorCodeDistribution::FillMode::Exact
+                                                        : ErrorCodeDistribution::FillMode::Auto,
+                                        &stats);
+        if (!distribution) {
+            info << "Site not found: " << queue_name << std::endl;
+            return -1;
         }
+        reportConstantQueue(info, queue_name, *distribution);
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
     }
 
-    // Extract error codes and counts for the target site
-    std::map<std::string, int> errorCodes;
-    if (dictionary.count(queue_name) > 0) {
-        for (const auto& [code, count] : dictionary[queue_name]) {
-            errorCodes[code] = count;
-        }
-    } else {
-        std::cout << "Site not found: " << queue_name << std::endl;
-        return -1;
+    // A single-stream ErrorCodeGenerator(distribution, seed) is what you would embed and call
+    // getNextErrorCode() or fill() on. Here the codes are generated in blocks, each from its
+    // own stream derived from the seed, so the result is the same for any number of threads.
+    stats.phase("draw");
+    try {
+        withEngine(arguments.engine, [&](auto engine) {
+            using Engine = typename decltype(engine)::type;
+            if (arguments.output_file.empty()) {
+                generateErrorCodes<Engine>(distribution, arguments);
+            } else {
+                writeErrorCodes<Engine>(distribution, arguments, resumeFrom ? &*resumeFrom : nullptr, stats);
+            }
+        });
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
     }
+    stats.stop();
+    stats.addDraws(arguments.n - (resumeFrom ? resumeFrom->position : 0));
 
-    // Create an instance of the ErrorCodeGenerator class
-    ErrorCodeGenerator generator(errorCodes);
-    
-    // Now you can call getNextErrorCode() whenever you need a new error code.
-    for (int i = 0; i < n; ++i) {
-        int errorCode = generator.getNextErrorCode();
-        // std::cout << "Random error code: " << errorCode << std::endl;
+    if (!arguments.stats.empty()) {
+        stats.setAllocations(allocationCount(), allocatedBytes());
+        if (arguments.stats == "json") {
+            stats.printJson(info);
+        } else {
+            stats.print(info);
+        }
     }
     
     return 0;
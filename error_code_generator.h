@@ -0,0 +1,121 @@
+// ==============================================
+// Description: Random error code generator for one queue: a shared
+//              ErrorCodeDistribution plus a private random engine. The
+//              engine is a template policy (see random_engines.h). Its state
+//              can be checkpointed and restored (see generator_checkpoint.h).
+// ==============================================
+
+#ifndef ERROR_CODE_GENERATOR_H
+#define ERROR_CODE_GENERATOR_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "error_code_distribution.h"
+#include "generator_checkpoint.h"
+#include "random_engines.h"
+
+template <class Engine = Xoshiro256StarStar>
+class BasicErrorCodeGenerator {
+public:
+    using FillMode = ErrorCodeDistribution::FillMode;
+    using engine_type = Engine;
+
+    // The constructor builds the distribution and seeds the engine from std::random_device.
+    BasicErrorCodeGenerator(const std::map<std::string, int>& errorCodes, FillMode mode = FillMode::Auto)
+        : BasicErrorCodeGenerator(errorCodes, randomSeed(), mode) {}
+
+    BasicErrorCodeGenerator(const std::map<std::string, int>& errorCodes, std::uint64_t seed,
+                            FillMode mode = FillMode::Auto)
+        : BasicErrorCodeGenerator(std::make_shared<const ErrorCodeDistribution>(errorCodes, mode), seed) {}
+
+    // Generators built from the same distribution share its tables; only the engine is private.
+    BasicErrorCodeGenerator(std::shared_ptr<const ErrorCodeDistribution> distribution, std::uint64_t seed)
+        : distribution_(std::move(distribution)), gen_(seed) {}
+
+    BasicErrorCodeGenerator(std::shared_ptr<const ErrorCodeDistribution> distribution, Engine engine)
+        : distribution_(std::move(distribution)), gen_(std::move(engine)) {}
+
+    // This function returns the next random error code.
+    int getNextErrorCode() {
+        ++position_;
+        return distribution_->draw(gen_);
+    }
+
+    // This function returns the next failure (non-zero error code) together with the
+    // number of successes that precede it, using a single geometric draw for the gap.
+    SkipSampler::Failure nextFailure() {
+        const SkipSampler::Failure failure = distribution_->nextFailure(gen_);
+        // A gap of UINT64_MAX stands for a failure that never comes
+        position_ += failure.gap == UINT64_MAX ? 0 : failure.gap + 1;
+        return failure;
+    }
+
+    // This function fills a caller-provided buffer with the next count error codes.
+    void fill(int* out, std::size_t count) {
+        distribution_->fill(gen_, out, count);
+        position_ += count;
+    }
+
+    void fill(std::vector<int>& out) {
+        fill(out.data(), out.size());
+    }
+
+    // This function generates n error codes in chunks of at most chunkSize and hands each
+    // chunk to consumer(const int* codes, std::size_t size). Only one chunk is held in
+    // memory at a time.
+    template <class Consumer>
+    void generate(std::size_t n, std::size_t chunkSize, Consumer&& consumer) {
+        std::vector<int> chunk(std::min(n, std::max<std::size_t>(chunkSize, 1)));
+        while (n > 0) {
+            const std::size_t len = std::min(n, chunk.size());
+            fill(chunk.data(), len);
+            consumer(static_cast<const int*>(chunk.data()), len);
+            n -= len;
+        }
+    }
+
+    // This function returns a checkpoint of the generator: the engine state, the position and
+    // the hash of the distribution tables, in a blob of a few dozen bytes (see
+    // generator_checkpoint.h).
+    std::vector<unsigned char> checkpoint() const {
+        generator_checkpoint::State state;
+        state.engine = engineName<Engine>();
+        state.tableHash = generator_checkpoint::tableHash(*distribution_);
+        state.position = position_;
+        state.engineState = saveEngineState(gen_);
+        return generator_checkpoint::serialize(state);
+    }
+
+    // This function continues from a checkpoint() blob: the next codes are the ones the
+    // checkpointed generator would have drawn next. It copies the engine state back rather than
+    // replaying the draws, so it takes O(state size). Throws std::runtime_error if the blob is
+    // damaged or was taken with another engine or other tables, and std::invalid_argument if
+    // the engine state is invalid.
+    void restore(const std::vector<unsigned char>& checkpoint) {
+        const generator_checkpoint::State state = generator_checkpoint::deserialize(checkpoint.data(), checkpoint.size());
+        generator_checkpoint::verify(state, generator_checkpoint::Kind::Stream, engineName<Engine>(), *distribution_);
+        loadEngineState(gen_, state.engineState);
+        position_ = state.position;
+    }
+
+    const std::shared_ptr<const ErrorCodeDistribution>& distribution() const { return distribution_; }
+
+    Engine& engine() { return gen_; }
+
+    // Number of codes generated so far, including the successes nextFailure() skipped over
+    std::uint64_t position() const { return position_; }
+
+private:
+    std::shared_ptr<const ErrorCodeDistribution> distribution_;
+    Engine gen_;
+    std::uint64_t position_{0};
+};
+
+using ErrorCodeGenerator = BasicErrorCodeGenerator<>;
+
+#endif // ERROR_CODE_GENERATOR_H
@@ -0,0 +1,205 @@
+// ==============================================
+// Description: Streaming (SAX) loader for error_codes.json that keeps only
+//              the requested queue, and loaders that accept either JSON or
+//              the compiled binary format
+// ==============================================
+
+#include "error_code_loader.h"
+
+#include <climits>
+#include <cstdint>
+#include <fstream>
+#include <stdexcept>
+#include <nlohmann/json.hpp>
+#include "error_code_binary.h"
+
+using json = nlohmann::json;
+
+namespace {
+
+// SAX handler for {"<queue>": {"<code>": <count>, ...}, ...}. With a queue name, everything
+// outside that queue is skipped without being stored and parsing stops once the queue is
+// complete; without one, every queue is collected.
+class QueueHandler : public nlohmann::json_sax<json> {
+public:
+    // input is the stream being parsed, used to report where a bad count is
+    QueueHandler(const std::string* queue_name, std::istream& input) : queue_name_(queue_name), input_(input) {}
+
+    bool null() override { return scalar(); }
+    bool boolean(bool) override { return scalar(); }
+    bool number_integer(number_integer_t value) override {
+        return value < INT_MIN || value > INT_MAX ? outOfRange() : count(static_cast<int>(value));
+    }
+    bool number_unsigned(number_unsigned_t value) override {
+        return value > static_cast<number_unsigned_t>(INT_MAX) ? outOfRange() : count(static_cast<int>(value));
+    }
+    bool number_float(number_float_t, const string_t&) override { return scalar(); }
+    bool string(string_t&) override { return scalar(); }
+    bool binary(binary_t&) override { return scalar(); }
+
+    bool start_object(std::size_t) override {
+        ++depth_;
+        if (depth_ == 2 && (queue_name_ == nullptr || key_ == *queue_name_)) {
+            found_ = true;
+            current_ = &queues_[key_];
+            currentName_ = key_;
+        }
+        return true;
+    }
+
+    bool end_object() override {
+        if (current_ != nullptr && depth_ == 2) {
+            current_ = nullptr;
+            if (queue_name_ != nullptr) {
+                // The queue is complete, returning false stops the parser here
+                done_ = true;
+                return false;
+            }
+        }
+        --depth_;
+        return true;
+    }
+
+    bool start_array(std::size_t) override {
+        ++depth_;
+        return true;
+    }
+
+    bool end_array() override {
+        --depth_;
+        return true;
+    }
+
+    bool key(string_t& val) override {
+        key_ = val;
+        return true;
+    }
+
+    bool parse_error(std::size_t position, const std::string&, const nlohmann::detail::exception& ex) override {
+        error_ = "Error: Failed to parse input at byte " + std::to_string(position) + ": " + ex.what();
+        return false;
+    }
+
+    bool found() const { return found_; }
+    bool done() const { return done_; }
+    const std::string& error() const { return error_; }
+    std::map<std::string, std::map<std::string, int>>& queues() { return queues_; }
+
+private:
+    bool scalar() {
+        if (current_ != nullptr && depth_ == 2) {
+            error_ = "Error: Count of error code '" + key_ + "' in " + currentName_ + " is not an integer.";
+            return false;
+        }
+        return true;
+    }
+
+    bool count(int value) {
+        if (current_ != nullptr && depth_ == 2) {
+            (*current_)[key_] = value;
+        }
+        return true;
+    }
+
+    // Counts are stored as int; a larger one must not be truncated. The stream has just read
+    // the number (and the character after it), which locates it closely enough.
+    bool outOfRange() {
+        if (current_ == nullptr || depth_ != 2) {
+            return true;
+        }
+        const std::streamoff position = input_.rdbuf()->pubseekoff(0, std::ios::cur, std::ios::in);
+        error_ = "Error: Failed to parse input" +
+                 (position >= 0 ? " at byte " + std::to_string(position) : std::string()) + ": count of error code '" +
+                 key_ + "' in " + currentName_ + " does not fit in an int.";
+        return false;
+    }
+
+    const std::string* queue_name_;
+    std::istream& input_;
+    std::string key_;
+    std::string currentName_;
+    int depth_{0};
+    bool found_{false};
+    bool done_{false};
+    std::string error_;
+    std::map<std::string, int>* current_{nullptr};
+    std::map<std::string, std::map<std::string, int>> queues_;
+};
+
+} // namespace
+
+
+std::optional<std::map<std::string, int>> loadQueue(std::istream& input, const std::string& queue_name) {
+    QueueHandler handler(&queue_name, input);
+    const bool complete = json::sax_parse(input, &handler);
+    if (!complete && !handler.done()) {
+        throw std::runtime_error(handler.error().empty() ? "Error: Failed to parse input." : handler.error());
+    }
+    if (!handler.found()) {
+        return std::nullopt;
+    }
+    return std::move(handler.queues().begin()->second);
+}
+
+std::optional<std::map<std::string, int>> loadQueue(const std::string& input_file, const std::string& queue_name) {
+    if (error_code_binary::isBinaryFile(input_file)) {
+        error_code_binary::MappedFile mapped(input_file);
+        const std::optional<std::size_t> queue = mapped.findQueue(queue_name);
+        if (!queue) {
+            return std::nullopt;
+        }
+        return mapped.errorCodes(*queue);
+    }
+    std::ifstream file(input_file, std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error("Error: Could not open " + input_file);
+    }
+    return loadQueue(file, queue_name);
+}
+
+std::shared_ptr<const ErrorCodeDistribution> loadDistribution(const std::string& input_file,
+                                                              const std::string& queue_name,
+                                                              ErrorCodeDistribution::FillMode mode, RunStats* stats) {
+    if (stats) {
+        stats->phase("load");
+    }
+    std::shared_ptr<const ErrorCodeDistribution> distribution;
+    if (error_code_binary::isBinaryFile(input_file)) {
+        error_code_binary::MappedFile mapped(input_file);
+        const std::optional<std::size_t> queue = mapped.findQueue(queue_name);
+        if (queue) {
+            if (stats) {
+                stats->phase("build");
+            }
+            distribution = mapped.distribution(*queue, mode);
+        }
+    } else {
+        std::optional<std::map<std::string, int>> errorCodes = loadQueue(input_file, queue_name);
+        if (errorCodes) {
+            if (stats) {
+                stats->phase("build");
+            }
+            distribution = std::make_shared<const ErrorCodeDistribution>(*errorCodes, mode);
+        }
+    }
+    if (stats) {
+        stats->stop();
+    }
+    return distribution;
+}
+
+std::map<std::string, std::map<std::string, int>> loadAllQueues(std::istream& input) {
+    QueueHandler handler(nullptr, input);
+    if (!json::sax_parse(input, &handler)) {
+        throw std::runtime_error(handler.error().empty() ? "Error: Failed to parse input." : handler.error());
+    }
+    return std::move(handler.queues());
+}
+
+std::map<std::string, std::map<std::string, int>> loadAllQueues(const std::string& input_file) {
+    std::ifstream file(input_file, std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error("Error: Could not open " + input_file);
+    }
+    return loadAllQueues(file);
+}
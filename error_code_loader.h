@@ -0,0 +1,42 @@
+// ==============================================
+// Description: Streaming (SAX) loader for error_codes.json that keeps only
+//              the requested queue, and loaders that accept either JSON or
+//              the compiled binary format
+// ==============================================
+
+#ifndef ERROR_CODE_LOADER_H
+#define ERROR_CODE_LOADER_H
+
+#include <istream>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include "error_code_distribution.h"
+#include "run_stats.h"
+
+// This function streams the JSON document in input and returns the error codes and counts of
+// queue_name, or std::nullopt if the document has no such queue. Parsing stops as soon as the
+// queue's object is closed, and no other queue is kept in memory. Throws std::runtime_error
+// if the document is malformed before the queue is complete.
+std::optional<std::map<std::string, int>> loadQueue(std::istream& input, const std::string& queue_name);
+
+// The same for a file, which may be either JSON or the binary format written by
+// error_code_compiler. Throws std::runtime_error if the file cannot be opened.
+std::optional<std::map<std::string, int>> loadQueue(const std::string& input_file, const std::string& queue_name);
+
+// This function streams the whole JSON document and returns every queue's error codes and
+// counts, keyed by queue name. Throws std::runtime_error if the document is malformed.
+std::map<std::string, std::map<std::string, int>> loadAllQueues(std::istream& input);
+std::map<std::string, std::map<std::string, int>> loadAllQueues(const std::string& input_file);
+
+// This function returns the sampling distribution of queue_name, or nullptr if the file has no
+// such queue. Binary files are memory-mapped and their precomputed alias tables are used as
+// they are; JSON files are streamed with loadQueue() and the tables are built here. If stats
+// is given, reading the file and building the tables are timed as its "load" and "build"
+// phases.
+std::shared_ptr<const ErrorCodeDistribution> loadDistribution(
+    const std::string& input_file, const std::string& queue_name,
+    ErrorCodeDistribution::FillMode mode = ErrorCodeDistribution::FillMode::Auto, RunStats* stats = nullptr);
+
+#endif // ERROR_CODE_LOADER_H
@@ -0,0 +1,30 @@
+// ==============================================
+// Description: Strict parsing of the error code keys of a queue dictionary,
+//              shared by every loader and generator of the library
+// ==============================================
+
+#ifndef ERROR_CODE_PARSER_H
+#define ERROR_CODE_PARSER_H
+
+#include <stdexcept>
+#include <string>
+
+// This function converts an error code key such as "1305" to int. The whole key must be an
+// integer in the range of int; "13x", "" and "99999999999" are rejected. Throws
+// std::invalid_argument naming the code and, if given, the queue it belongs to.
+inline int parseErrorCode(const std::string& code, const std::string& queue = std::string()) {
+    std::size_t end = 0;
+    int value = 0;
+    try {
+        value = std::stoi(code, &end);
+    } catch (const std::exception&) {
+        end = 0;
+    }
+    if (end == 0 || end != code.size()) {
+        throw std::invalid_argument("Error: '" + code + "'" + (queue.empty() ? "" : " in " + queue) +
+                                    " is not a valid integer error code.");
+    }
+    return value;
+}
+
+#endif // ERROR_CODE_PARSER_H
@@ -0,0 +1,149 @@
+// ==============================================
+// Description: Exact sampler over integer counts: 64-bit cumulative counts
+//              and one unbiased bounded integer draw, so every code comes
+//              out with exactly its empirical frequency. Small queues are
+//              searched with a branchless SIMD compare over 32-bit counts.
+// ==============================================
+
+#ifndef EXACT_SAMPLER_H
+#define EXACT_SAMPLER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// This function returns a uniform integer in [0, bound) using Lemire's multiply-shift method.
+// The high half of x * bound is the result; the rare x whose low half falls in the biased
+// sliver below 2^64 mod bound are rejected and redrawn, so the result is exactly uniform.
+// The modulo is only computed on that slow path.
+template <class URBG>
+std::uint64_t boundedRandom(URBG& gen, std::uint64_t bound) {
+    static_assert(URBG::max() - URBG::min() == UINT64_MAX, "boundedRandom needs a 64-bit engine");
+    unsigned __int128 m = static_cast<unsigned __int128>(static_cast<std::uint64_t>(gen() - URBG::min())) * bound;
+    if (static_cast<std::uint64_t>(m) < bound) {
+        const std::uint64_t threshold = (0 - bound) % bound;
+        while (static_cast<std::uint64_t>(m) < threshold) {
+            m = static_cast<unsigned __int128>(static_cast<std::uint64_t>(gen() - URBG::min())) * bound;
+        }
+    }
+    return static_cast<std::uint64_t>(m >> 64);
+}
+
+class ExactSampler {
+public:
+    // Queues with at most this many codes and a total below 2^32 use the SIMD search
+    static constexpr std::size_t kSmallSize = 16;
+
+    ExactSampler() = default;
+
+    // Build the cumulative counts from parallel vectors of error codes and their counts.
+    // Codes with a zero count are kept but never drawn. Throws std::invalid_argument if the
+    // counts are all zero and std::overflow_error if their total exceeds 2^64 - 1.
+    ExactSampler(const std::vector<int>& codes, const std::vector<std::uint64_t>& counts) {
+        if (codes.empty() || codes.size() != counts.size()) {
+            throw std::invalid_argument("Error: ExactSampler needs one count per error code.");
+        }
+        codes_ = codes;
+        cumulative_.reserve(counts.size());
+        std::uint64_t total = 0;
+        for (std::uint64_t count : counts) {
+            if (count > UINT64_MAX - total) {
+                throw std::overflow_error("Error: ExactSampler total count exceeds 2^64 - 1.");
+            }
+            total += count;
+            cumulative_.push_back(total);
+        }
+        if (total == 0) {
+            throw std::invalid_argument("Error: ExactSampler counts must not all be zero.");
+        }
+        if (codes.size() <= kSmallSize && total <= UINT32_MAX) {
+            // Unused lanes hold UINT32_MAX, which never counts since r < total
+            small_ = true;
+            for (std::size_t i = 0; i < kSmallSize; ++i) {
+                smallCumulative_[i] = i < codes.size() ? static_cast<std::uint32_t>(cumulative_[i]) : UINT32_MAX;
+            }
+        }
+    }
+
+    // Draw one error code: r is uniform in [0, total), and the code is the first one whose
+    // cumulative count exceeds r, found by a branchless binary search or, for a small queue,
+    // by counting the cumulative counts not above r. Both searches give the same code.
+    template <class URBG>
+    int operator()(URBG& gen) const {
+        return code(boundedRandom(gen, total()));
+    }
+
+    // The code a draw of r in [0, total()) returns.
+    int code(std::uint64_t r) const { return codes_[find(r)]; }
+
+    // Fill out[0..count) with error codes.
+    template <class URBG>
+    void fill(URBG& gen, int* out, std::size_t count) const {
+        for (std::size_t i = 0; i < count; ++i) {
+            out[i] = (*this)(gen);
+        }
+    }
+
+    std::uint64_t total() const { return cumulative_.back(); }
+    std::size_t size() const { return codes_.size(); }
+    bool small() const { return small_; }
+
+    const std::vector<int>& codes() const { return codes_; }
+    const std::vector<std::uint64_t>& cumulative() const { return cumulative_; }
+
+private:
+    // The index of the code for r. In the binary search the answer stays in [first, first + n)
+    // while n halves; the comparison compiles to a conditional move, so the search costs no
+    // branch mispredictions.
+    std::size_t find(std::uint64_t r) const {
+        if (small_) {
+            return findSmall(static_cast<std::uint32_t>(r));
+        }
+        const std::uint64_t* cumulative = cumulative_.data();
+        std::size_t first = 0;
+        std::size_t n = cumulative_.size();
+        while (n > 1) {
+            const std::size_t half = n / 2;
+            first = cumulative[first + half - 1] <= r ? first + half : first;
+            n -= half;
+        }
+        return first;
+    }
+
+    // The index of the first cumulative count above r is the number of counts not above it,
+    // i.e. 16 minus the number above it. With SSE2 the 16 counts are compared in four
+    // registers. SSE2 has no unsigned compare, so both sides are offset by 2^31 and compared
+    // as signed. Each lane above r is -1, and the lanes are summed instead of moving a mask
+    // out and counting its bits.
+    std::size_t findSmall(std::uint32_t r) const {
+#if defined(__SSE2__)
+        const __m128i bias = _mm_set1_epi32(INT32_MIN);
+        const __m128i key = _mm_xor_si128(_mm_set1_epi32(static_cast<int>(r)), bias);
+        const auto* lanes = reinterpret_cast<const __m128i*>(smallCumulative_);
+        __m128i sum = _mm_setzero_si128();
+        for (int i = 0; i < 4; ++i) {
+            sum = _mm_add_epi32(sum, _mm_cmpgt_epi32(_mm_xor_si128(_mm_load_si128(lanes + i), bias), key));
+        }
+        sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+        sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+        return static_cast<std::size_t>(static_cast<int>(kSmallSize) + _mm_cvtsi128_si32(sum));
+#else
+        std::size_t index = 0;
+        for (std::size_t i = 0; i < kSmallSize; ++i) {
+            index += smallCumulative_[i] <= r;
+        }
+        return index;
+#endif
+    }
+
+    std::vector<int> codes_;
+    std::vector<std::uint64_t> cumulative_;
+    alignas(64) std::uint32_t smallCumulative_[kSmallSize]{};
+    bool small_{false};
+};
+
+#endif // EXACT_SAMPLER_H
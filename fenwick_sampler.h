@@ -0,0 +1,171 @@
+// ==============================================
+// Description: Mutable discrete sampler backed by a Fenwick (binary
+//              indexed) tree over integer counts: O(log k) draws and
+//              O(log k) count updates without rebuilding any table
+// ==============================================
+
+#ifndef FENWICK_SAMPLER_H
+#define FENWICK_SAMPLER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+class FenwickSampler {
+public:
+    FenwickSampler() = default;
+
+    // Build the tree from parallel vectors of error codes and their counts in O(k). Zero
+    // counts are allowed, and so is a total of zero as long as nothing is drawn before the
+    // first increment().
+    FenwickSampler(const std::vector<int>& codes, const std::vector<std::uint64_t>& counts) {
+        if (codes.size() != counts.size()) {
+            throw std::invalid_argument("Error: FenwickSampler needs one count per error code.");
+        }
+        codes_ = codes;
+        counts_ = counts;
+        tree_.assign(codes.size() + 1, 0);
+        index_.reserve(codes.size());
+        for (std::size_t i = 0; i < codes.size(); ++i) {
+            if (!index_.emplace(codes[i], i).second) {
+                throw std::invalid_argument("Error: FenwickSampler error codes must be unique.");
+            }
+            addTotal(counts[i]);
+            // Linear-time construction: every node passes its sum on to its parent
+            tree_[i + 1] += counts[i];
+            const std::size_t parent = (i + 1) + lowBit(i + 1);
+            if (parent < tree_.size()) {
+                tree_[parent] += tree_[i + 1];
+            }
+        }
+        updateStep();
+    }
+
+    // This function adds delta to the count of code in O(log k). A code that has not been
+    // seen before is appended, also in O(log k). Throws std::invalid_argument if the count
+    // would become negative and std::overflow_error if the total would exceed 2^64 - 1.
+    void increment(int code, std::int64_t delta) {
+        auto it = index_.find(code);
+        if (it == index_.end()) {
+            if (delta < 0) {
+                throw std::invalid_argument("Error: Count of error code " + std::to_string(code) +
+                                            " must not become negative.");
+            }
+            append(code, static_cast<std::uint64_t>(delta));
+            return;
+        }
+        const std::size_t i = it->second;
+        if (delta < 0) {
+            const std::uint64_t decrement = static_cast<std::uint64_t>(-(delta + 1)) + 1;
+            if (decrement > counts_[i]) {
+                throw std::invalid_argument("Error: Count of error code " + std::to_string(code) +
+                                            " must not become negative.");
+            }
+            counts_[i] -= decrement;
+            total_ -= decrement;
+            for (std::size_t j = i + 1; j < tree_.size(); j += lowBit(j)) {
+                tree_[j] -= decrement;
+            }
+        } else {
+            const std::uint64_t increment = static_cast<std::uint64_t>(delta);
+            addTotal(increment);
+            counts_[i] += increment;
+            for (std::size_t j = i + 1; j < tree_.size(); j += lowBit(j)) {
+                tree_[j] += increment;
+            }
+        }
+    }
+
+    // Draw one error code in O(log k). The 64-bit random number is scaled to [0, total) by a
+    // 64x64->128 multiply, then the tree is descended from the root towards the first code
+    // whose cumulative count exceeds it. Throws std::logic_error if all counts are zero.
+    template <class URBG>
+    int operator()(URBG& gen) const {
+        static_assert(URBG::max() - URBG::min() == UINT64_MAX, "FenwickSampler needs a 64-bit engine");
+        if (total_ == 0) {
+            throw std::logic_error("Error: FenwickSampler counts must not all be zero.");
+        }
+        const std::uint64_t x = static_cast<std::uint64_t>(gen() - URBG::min());
+        std::uint64_t r = static_cast<std::uint64_t>((static_cast<unsigned __int128>(x) * total_) >> 64);
+        std::size_t position = 0;
+        for (std::size_t step = step_; step > 0; step >>= 1) {
+            const std::size_t next = position + step;
+            if (next < tree_.size() && tree_[next] <= r) {
+                position = next;
+                r -= tree_[next];
+            }
+        }
+        return codes_[position];
+    }
+
+    // Fill out[0..count) with error codes.
+    template <class URBG>
+    void fill(URBG& gen, int* out, std::size_t count) const {
+        for (std::size_t i = 0; i < count; ++i) {
+            out[i] = (*this)(gen);
+        }
+    }
+
+    // This function returns the current count of code, or 0 for an unknown code.
+    std::uint64_t count(int code) const {
+        const auto it = index_.find(code);
+        return it == index_.end() ? 0 : counts_[it->second];
+    }
+
+    std::uint64_t total() const { return total_; }
+    std::size_t size() const { return codes_.size(); }
+
+    const std::vector<int>& codes() const { return codes_; }
+    const std::vector<std::uint64_t>& counts() const { return counts_; }
+
+private:
+    static std::size_t lowBit(std::size_t i) { return i & (~i + 1); }
+
+    void addTotal(std::uint64_t value) {
+        if (value > UINT64_MAX - total_) {
+            throw std::overflow_error("Error: FenwickSampler total count exceeds 2^64 - 1.");
+        }
+        total_ += value;
+    }
+
+    // Node i covers codes (i - lowBit(i), i], so a new last node holds its own count plus
+    // the counts of the nodes it now covers.
+    void append(int code, std::uint64_t value) {
+        addTotal(value);
+        const std::size_t i = tree_.empty() ? 1 : tree_.size();
+        if (tree_.empty()) {
+            tree_.push_back(0);
+        }
+        std::uint64_t node = value;
+        for (std::size_t j = i - 1; j > i - lowBit(i); j -= lowBit(j)) {
+            node += tree_[j];
+        }
+        tree_.push_back(node);
+        index_.emplace(code, codes_.size());
+        codes_.push_back(code);
+        counts_.push_back(value);
+        updateStep();
+    }
+
+    // Largest power of two not above the number of codes, where the descent starts
+    void updateStep() {
+        step_ = 1;
+        while (step_ * 2 < tree_.size()) {
+            step_ *= 2;
+        }
+        if (tree_.size() <= 1) {
+            step_ = 0;
+        }
+    }
+
+    std::vector<int> codes_;
+    std::vector<std::uint64_t> counts_;
+    std::vector<std::uint64_t> tree_; // 1-based; tree_[0] is unused
+    std::unordered_map<int, std::size_t> index_;
+    std::uint64_t total_{0};
+    std::size_t step_{0};
+};
+
+#endif // FENWICK_SAMPLER_H
@@ -0,0 +1,175 @@
+// ==============================================
+// Description: Serialization, verification and files of generator
+//              checkpoints (see generator_checkpoint.h)
+// ==============================================
+
+#include "generator_checkpoint.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+namespace generator_checkpoint {
+
+namespace {
+
+class Fnv1a {
+public:
+    template <class T>
+    void add(const T& value) {
+        const auto* bytes = reinterpret_cast<const unsigned char*>(&value);
+        for (std::size_t i = 0; i < sizeof(T); ++i) {
+            hash_ = (hash_ ^ bytes[i]) * 0x100000001b3ULL;
+        }
+    }
+
+    std::uint64_t value() const { return hash_; }
+
+private:
+    std::uint64_t hash_{0xcbf29ce484222325ULL};
+};
+
+} // namespace
+
+
+std::uint64_t tableHash(const ErrorCodeDistribution& distribution) {
+    Fnv1a hash;
+    hash.add(static_cast<std::uint32_t>(distribution.fillMode()));
+    hash.add(static_cast<std::uint32_t>(distribution.exactDraws()));
+    hash.add(static_cast<std::uint64_t>(distribution.codes().size()));
+    for (std::size_t i = 0; i < distribution.codes().size(); ++i) {
+        hash.add(static_cast<std::int32_t>(distribution.codes()[i]));
+        hash.add(distribution.weights()[i]);
+    }
+    // A constant queue draws nothing from its alias table, which some sources leave empty
+    if (!distribution.isConstant()) {
+        for (const AliasSampler::Column& column : distribution.aliasSampler().columns()) {
+            hash.add(column.threshold);
+            hash.add(static_cast<std::int32_t>(column.code));
+            hash.add(static_cast<std::int32_t>(column.alias));
+        }
+    }
+    return hash.value();
+}
+
+std::vector<unsigned char> serialize(const State& state) {
+    Header header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.byteOrderMark = kByteOrderMark;
+    if (state.engine.size() >= sizeof(header.engine)) {
+        throw std::invalid_argument("Error: Engine name too long for a checkpoint: " + state.engine);
+    }
+    std::memcpy(header.engine, state.engine.data(), state.engine.size());
+    if (state.outputFormat.size() >= sizeof(header.outputFormat)) {
+        throw std::invalid_argument("Error: Output format name too long for a checkpoint: " + state.outputFormat);
+    }
+    std::memcpy(header.outputFormat, state.outputFormat.data(), state.outputFormat.size());
+    header.tableHash = state.tableHash;
+    header.seed = state.seed;
+    header.position = state.position;
+    header.total = state.total;
+    header.outputBytes = state.outputBytes;
+    header.kind = static_cast<std::uint32_t>(state.kind);
+    header.stateWords = static_cast<std::uint32_t>(state.engineState.size());
+
+    std::vector<unsigned char> blob(sizeof(Header) + state.engineState.size() * sizeof(std::uint64_t));
+    std::memcpy(blob.data(), &header, sizeof(header));
+    if (!state.engineState.empty()) {
+        std::memcpy(blob.data() + sizeof(header), state.engineState.data(),
+                    state.engineState.size() * sizeof(std::uint64_t));
+    }
+    return blob;
+}
+
+State deserialize(const unsigned char* data, std::size_t size) {
+    Header header;
+    if (size < sizeof(header)) {
+        throw std::runtime_error("Error: Checkpoint is truncated.");
+    }
+    std::memcpy(&header, data, sizeof(header));
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0) {
+        throw std::runtime_error("Error: Not a generator checkpoint.");
+    }
+    if (header.version != kVersion) {
+        throw std::runtime_error("Error: Unsupported checkpoint version " + std::to_string(header.version) + ".");
+    }
+    if (header.byteOrderMark != kByteOrderMark) {
+        throw std::runtime_error("Error: Checkpoint was written on a machine with another byte order.");
+    }
+    if (header.kind > static_cast<std::uint32_t>(Kind::Parallel) || header.engine[sizeof(header.engine) - 1] != '\0' ||
+        header.outputFormat[sizeof(header.outputFormat) - 1] != '\0' ||
+        size != sizeof(header) + std::uint64_t{header.stateWords} * sizeof(std::uint64_t)) {
+        throw std::runtime_error("Error: Checkpoint is corrupt.");
+    }
+
+    State state;
+    state.kind = static_cast<Kind>(header.kind);
+    state.engine = header.engine;
+    state.tableHash = header.tableHash;
+    state.seed = header.seed;
+    state.position = header.position;
+    state.total = header.total;
+    state.outputFormat = header.outputFormat;
+    state.outputBytes = header.outputBytes;
+    state.engineState.resize(header.stateWords);
+    if (header.stateWords != 0) {
+        std::memcpy(state.engineState.data(), data + sizeof(header), header.stateWords * sizeof(std::uint64_t));
+    }
+    return state;
+}
+
+void verify(const State& state, Kind kind, const std::string& engine, const ErrorCodeDistribution& distribution) {
+    if (state.kind != kind) {
+        throw std::runtime_error(kind == Kind::Parallel
+                                     ? "Error: Checkpoint is of a single generator, not of a parallel run."
+                                     : "Error: Checkpoint is of a parallel run, not of a single generator.");
+    }
+    if (state.engine != engine) {
+        throw std::runtime_error("Error: Checkpoint was taken with engine " + state.engine + ", not " + engine + ".");
+    }
+    if (state.tableHash != tableHash(distribution)) {
+        throw std::runtime_error("Error: Checkpoint was taken with different distribution tables or fill mode.");
+    }
+    if (state.total != 0 && state.position > state.total) {
+        throw std::runtime_error("Error: Checkpoint position " + std::to_string(state.position) +
+                                 " is beyond the end of its run of " + std::to_string(state.total) + " codes.");
+    }
+    if (kind == Kind::Parallel && state.position % kParallelBlockSize != 0 && state.position != state.total) {
+        throw std::runtime_error("Error: Checkpoint position " + std::to_string(state.position) +
+                                 " is not at a block boundary.");
+    }
+}
+
+void save(const std::string& path, const std::vector<unsigned char>& checkpoint) {
+    const std::string temporary = path + ".tmp";
+    {
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(checkpoint.data()), static_cast<std::streamsize>(checkpoint.size()));
+        out.close();
+        if (!out) {
+            std::remove(temporary.c_str());
+            throw std::runtime_error("Error: Could not write checkpoint " + temporary);
+        }
+    }
+    if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+        std::remove(temporary.c_str());
+        throw std::runtime_error("Error: Could not replace checkpoint " + path);
+    }
+}
+
+std::vector<unsigned char> load(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in.is_open()) {
+        throw std::runtime_error("Error: Could not open checkpoint " + path);
+    }
+    std::vector<unsigned char> checkpoint((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    if (in.bad()) {
+        throw std::runtime_error("Error: Could not read checkpoint " + path);
+    }
+    return checkpoint;
+}
+
+} // namespace generator_checkpoint
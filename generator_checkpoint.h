@@ -0,0 +1,96 @@
+// ==============================================
+// Description: Compact binary checkpoints of generator state, so that a
+//              long simulation can stop and later continue exactly where
+//              it was. A checkpoint holds the engine and its full state,
+//              the stream position and a hash that identifies the
+//              distribution tables the codes were drawn from.
+// ==============================================
+
+#ifndef GENERATOR_CHECKPOINT_H
+#define GENERATOR_CHECKPOINT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "error_code_distribution.h"
+
+namespace generator_checkpoint {
+
+// Layout (all values in host byte order, which the byte order mark pins to little-endian in
+// practice):
+//
+//   Header
+//   uint64_t engineState[stateWords]
+constexpr char kMagic[8] = {'R', 'N', 'D', 'E', 'R', 'R', 'C', 'K'};
+constexpr std::uint32_t kVersion = 1;
+constexpr std::uint32_t kByteOrderMark = 0x01020304;
+
+// What was checkpointed. A Stream checkpoint comes from a BasicErrorCodeGenerator and carries
+// its engine state. A Parallel checkpoint comes from a BasicParallelGenerator, whose blocks are
+// always drawn from makeStream(seed, block), so the seed and the position are all it needs.
+enum class Kind : std::uint32_t { Stream = 0, Parallel = 1 };
+
+// Number of codes a parallel run draws from one stream before moving on to the next, so a
+// Parallel checkpoint can only resume at a multiple of it (or at the end of the run)
+constexpr std::uint64_t kParallelBlockSize = 1 << 16;
+
+struct Header {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t byteOrderMark;
+    char engine[16];      // engineName(), padded with NULs
+    char outputFormat[8]; // CodeWriter format name, padded with NULs
+    std::uint64_t tableHash;
+    std::uint64_t seed;
+    std::uint64_t position;
+    std::uint64_t total;
+    std::uint64_t outputBytes;
+    std::uint32_t kind;
+    std::uint32_t stateWords;
+};
+
+static_assert(sizeof(Header) == 88, "unexpected padding in Header");
+
+struct State {
+    Kind kind{Kind::Stream};
+    std::string engine;
+    std::uint64_t tableHash{0};
+    std::uint64_t seed{0};                  // master seed of a Parallel checkpoint
+    std::uint64_t position{0};              // number of codes generated before the checkpoint
+    std::uint64_t total{0};                 // number of codes a tool's run was asked for, if any
+    std::string outputFormat;               // format of a tool's output, if any
+    std::uint64_t outputBytes{0};           // bytes a tool had written for the codes before position
+    std::vector<std::uint64_t> engineState; // empty for a Parallel checkpoint
+};
+
+// This function returns a 64-bit FNV-1a hash of everything that decides which codes the
+// distribution draws: the fill mode, the sampler of single draws, the codes, the weights and
+// the alias table. Tables built
+// from the same counts hash alike whether they come from JSON, a binary file or embedded tables.
+std::uint64_t tableHash(const ErrorCodeDistribution& distribution);
+
+// This function returns the binary form of state.
+std::vector<unsigned char> serialize(const State& state);
+
+// This function parses a checkpoint. Throws std::runtime_error if data is not a complete
+// checkpoint of this version.
+State deserialize(const unsigned char* data, std::size_t size);
+
+// This function throws std::runtime_error unless state is a checkpoint of the given kind, taken
+// with the engine called engine and from tables that hash like those of distribution, whose
+// position is within its total (if set) and, for a Parallel checkpoint, at a block boundary.
+void verify(const State& state, Kind kind, const std::string& engine, const ErrorCodeDistribution& distribution);
+
+// This function writes a checkpoint to path. It goes to path.tmp first and is then renamed,
+// so that an interrupted write leaves the previous checkpoint intact. Throws
+// std::runtime_error if the file cannot be written.
+void save(const std::string& path, const std::vector<unsigned char>& checkpoint);
+
+// This function reads a checkpoint written by save(). Throws std::runtime_error if the file
+// cannot be read.
+std::vector<unsigned char> load(const std::string& path);
+
+} // namespace generator_checkpoint
+
+#endif // GENERATOR_CHECKPOINT_H
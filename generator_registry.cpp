@@ -0,0 +1,82 @@
+// ==============================================
+// Description: Registry of every queue of one input file (see
+//              generator_registry.h)
+// ==============================================
+
+#include "generator_registry.h"
+
+#include <limits>
+#include <stdexcept>
+#include "error_code_loader.h"
+
+GeneratorRegistry::GeneratorRegistry(const std::string& input_file, std::uint64_t seed, FillMode mode)
+    : seed_(seed), mode_(mode) {
+    if (error_code_binary::isBinaryFile(input_file)) {
+        // The mapping stays open so that tables can be read lazily
+        mapped_ = std::make_unique<error_code_binary::MappedFile>(input_file);
+        entries_.reserve(mapped_->queueCount());
+        for (std::size_t q = 0; q < mapped_->queueCount(); ++q) {
+            auto entry = std::make_unique<Entry>();
+            entry->name = std::string(mapped_->queueName(q));
+            entry->mappedIndex = q;
+            entries_.push_back(std::move(entry));
+        }
+    } else {
+        std::map<std::string, std::map<std::string, int>> queues = loadAllQueues(input_file);
+        entries_.reserve(queues.size());
+        for (auto& [name, errorCodes] : queues) {
+            auto entry = std::make_unique<Entry>();
+            entry->name = name;
+            entry->errorCodes = std::move(errorCodes);
+            entries_.push_back(std::move(entry));
+        }
+    }
+    if (entries_.size() > std::numeric_limits<std::uint32_t>::max()) {
+        throw std::runtime_error("Error: Too many queues in " + input_file);
+    }
+
+    // Keys view the names owned by the entries, which never move
+    index_.reserve(entries_.size());
+    for (std::size_t q = 0; q < entries_.size(); ++q) {
+        index_.emplace(entries_[q]->name, static_cast<std::uint32_t>(q));
+    }
+}
+
+std::optional<GeneratorRegistry::QueueHandle> GeneratorRegistry::find(std::string_view name) const {
+    const auto it = index_.find(name);
+    if (it == index_.end()) {
+        return std::nullopt;
+    }
+    return QueueHandle{it->second};
+}
+
+GeneratorRegistry::QueueHandle GeneratorRegistry::handle(std::string_view name) const {
+    const std::optional<QueueHandle> queue = find(name);
+    if (!queue) {
+        throw std::invalid_argument("Error: Site not found: " + std::string(name));
+    }
+    return *queue;
+}
+
+std::shared_ptr<const ErrorCodeDistribution> GeneratorRegistry::distribution(QueueHandle queue) const {
+    Entry& entry = *entries_.at(queue.index);
+    std::call_once(entry.distributionOnce, [&] {
+        if (mapped_) {
+            entry.distribution = mapped_->distribution(entry.mappedIndex, mode_);
+        } else {
+            entry.distribution = std::make_shared<const ErrorCodeDistribution>(entry.errorCodes, mode_);
+            // The counts are not needed once the tables exist
+            std::map<std::string, int>().swap(entry.errorCodes);
+        }
+    });
+    return entry.distribution;
+}
+
+ErrorCodeGenerator& GeneratorRegistry::generator(QueueHandle queue) {
+    Entry& entry = *entries_.at(queue.index);
+    std::call_once(entry.generatorOnce, [&] {
+        entry.generator = std::make_unique<ErrorCodeGenerator>(
+            distribution(queue), makeStream<ErrorCodeGenerator::engine_type>(seed_, queue.index));
+    });
+    return *entry.generator;
+}
@@ -0,0 +1,86 @@
+// ==============================================
+// Description: Registry of every queue of one input file. The file is read
+//              once, queue names are interned to dense handles and each
+//              queue's distribution and generator are built on first use.
+// ==============================================
+
+#ifndef GENERATOR_REGISTRY_H
+#define GENERATOR_REGISTRY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "error_code_binary.h"
+#include "error_code_distribution.h"
+#include "error_code_generator.h"
+#include "random_engines.h"
+
+class GeneratorRegistry {
+public:
+    using FillMode = ErrorCodeDistribution::FillMode;
+
+    // Dense index of an interned queue name. Handles are only meaningful for the registry that
+    // returned them and make every later lookup an array access.
+    struct QueueHandle {
+        std::uint32_t index;
+    };
+
+    // The constructor reads input_file, which may be either JSON or the binary format written
+    // by error_code_compiler, and interns its queue names. No alias table is built here. The
+    // generator of queue q is seeded with makeStream(seed, q), so its draws do not depend on
+    // which other queues are used or in what order. Throws std::runtime_error if the file
+    // cannot be read.
+    explicit GeneratorRegistry(const std::string& input_file, std::uint64_t seed = randomSeed(),
+                               FillMode mode = FillMode::Auto);
+
+    // This function returns the handle of queue name, or std::nullopt if there is no such queue.
+    std::optional<QueueHandle> find(std::string_view name) const;
+
+    // The same, but throws std::invalid_argument if there is no such queue.
+    QueueHandle handle(std::string_view name) const;
+
+    const std::string& name(QueueHandle queue) const { return entries_[queue.index]->name; }
+
+    std::size_t size() const { return entries_.size(); }
+
+    std::uint64_t seed() const { return seed_; }
+
+    // This function returns the distribution of a queue, building it on first use. It is safe
+    // to call from several threads; the distribution is built once and then shared, e.g. with
+    // a ParallelGenerator.
+    std::shared_ptr<const ErrorCodeDistribution> distribution(QueueHandle queue) const;
+
+    // This function returns the generator of a queue, building it on first use. Creating
+    // generators is thread-safe, but each generator owns its engine, so draws from the same
+    // queue must not run concurrently.
+    ErrorCodeGenerator& generator(QueueHandle queue);
+
+    ErrorCodeGenerator& generator(std::string_view name) { return generator(handle(name)); }
+
+private:
+    struct Entry {
+        std::string name;
+        std::map<std::string, int> errorCodes; // JSON input only
+        std::size_t mappedIndex{0};            // Binary input only
+        mutable std::once_flag distributionOnce;
+        mutable std::shared_ptr<const ErrorCodeDistribution> distribution;
+        std::once_flag generatorOnce;
+        std::unique_ptr<ErrorCodeGenerator> generator;
+    };
+
+    std::uint64_t seed_;
+    FillMode mode_;
+    std::unique_ptr<error_code_binary::MappedFile> mapped_;
+    // Entries hold once_flags, which cannot move, hence the extra indirection
+    std::vector<std::unique_ptr<Entry>> entries_;
+    std::unordered_map<std::string_view, std::uint32_t> index_;
+};
+
+#endif // GENERATOR_REGISTRY_H
@@ -0,0 +1,74 @@
+// ==============================================
+// Description: Error code histograms: counting draws, sampling count
+//              vectors directly and writing ROOT scripts
+// ==============================================
+
+#include "histogram.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+
+DenseCodeIndex::DenseCodeIndex(std::vector<int> codes) : codes_(std::move(codes)) {
+    std::sort(codes_.begin(), codes_.end());
+    codes_.erase(std::unique(codes_.begin(), codes_.end()), codes_.end());
+    if (codes_.empty()) {
+        return;
+    }
+    min_ = codes_.front();
+    const std::int64_t range = static_cast<std::int64_t>(codes_.back()) - min_ + 1;
+    if (range <= kMaxDirectRange) {
+        direct_.assign(static_cast<std::size_t>(range), 0);
+        for (std::uint32_t i = 0; i < codes_.size(); ++i) {
+            direct_[static_cast<std::size_t>(codes_[i] - min_)] = i;
+        }
+    }
+}
+
+
+void generateROOTScript(const std::unordered_map<int, std::uint64_t>& errorCounts, const std::string& filename) {
+    if (errorCounts.empty()) {
+        std::cerr << "Error: No error codes to histogram, no ROOT script written." << std::endl;
+        return;
+    }
+
+    std::ofstream file(filename);
+
+    if (!file) {
+        std::cerr << "Error: Could not create ROOT script file!" << std::endl;
+        return;
+    }
+
+    file << "#include <TH1F.h>\n";
+    file << "#include <TCanvas.h>\n";
+    file << "#include <TApplication.h>\n\n";
+
+    file << "void error_hist() {\n";
+    file << "    TCanvas *c1 = new TCanvas(\"c1\", \"Error Code Histogram\", 800, 600);\n";
+    
+    int numBins = errorCounts.size();
+    int minError = errorCounts.begin()->first;
+    int maxError = minError;
+
+    for (const auto& pair : errorCounts) {
+        if (pair.first < minError) minError = pair.first;
+        if (pair.first > maxError) maxError = pair.first;
+    }
+
+    file << "    TH1F *h = new TH1F(\"h\", \"Error Code Distribution;Error Code;Occurrences\", "
+         << numBins << ", " << minError - 0.5 << ", " << maxError + 0.5 << ");\n\n";
+
+    for (const auto& pair : errorCounts) {
+        file << "    h->Fill(" << pair.first << ", " << pair.second << ");\n";
+    }
+
+    file << "\n    h->SetFillColor(38);\n"; // Set histogram color
+    file << "    h->Draw();\n";
+    file << "    c1->SaveAs(\"error_hist.png\");\n"; // Save histogram as PNG
+    file << "}\n";
+
+    file.close();
+    std::cout << "ROOT script '" << filename << "' has been generated.\n";
+}
@@ -0,0 +1,142 @@
+// ==============================================
+// Description: Error code histograms: counting draws, sampling count
+//              vectors directly and writing ROOT scripts
+// ==============================================
+
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "binomial_sampler.h"
+#include "error_code_parser.h"
+#include "parallel_generator.h"
+#include "progress.h"
+#include "random_engines.h"
+
+// Dense numbering of a distribution's error codes, so that a histogram is a flat counter array
+// indexed by index(code). Codes spanning a small range are looked up in a direct table
+// (one load); otherwise a binary search over the sorted codes is used.
+class DenseCodeIndex {
+public:
+    // Largest code range that gets a direct lookup table
+    static constexpr std::int64_t kMaxDirectRange = 1 << 20;
+
+    explicit DenseCodeIndex(std::vector<int> codes);
+
+    // This function returns the dense index of code, which must be one of the indexed codes.
+    std::uint32_t index(int code) const {
+        if (!direct_.empty()) {
+            return direct_[static_cast<std::size_t>(static_cast<std::int64_t>(code) - min_)];
+        }
+        return static_cast<std::uint32_t>(std::lower_bound(codes_.begin(), codes_.end(), code) - codes_.begin());
+    }
+
+    int code(std::uint32_t index) const { return codes_[index]; }
+    std::size_t size() const { return codes_.size(); }
+
+private:
+    std::vector<int> codes_; // Sorted and unique
+    std::vector<std::uint32_t> direct_;
+    std::int64_t min_{0};
+};
+
+// Function to draw n individual random error codes and count how often each one occurs.
+// The codes are numbered densely up front and every worker thread counts into its own row of
+// a flat counter array, so a draw costs one increment; the rows are merged at the end. The
+// blocks are seeded from the generator's master seed, so the counts are the same for any
+// number of threads. Memory use does not depend on n; if progress is given, every finished
+// block is reported to it.
+template <class Engine>
+std::unordered_map<int, std::uint64_t> countErrorCodes(const BasicParallelGenerator<Engine>& generator, std::uint64_t n,
+                                                       ProgressReporter* progress = nullptr) {
+    std::vector<int> indexed = generator.distribution()->codes();
+    if (generator.distribution()->isConstant()) {
+        // A queue whose counts are all zero draws the success code, which need not be one of its codes
+        indexed.push_back(generator.distribution()->constantCode());
+    }
+    const DenseCodeIndex index(std::move(indexed));
+    // Rows are padded by a cache line so that threads never write to the same line
+    const std::size_t stride = (index.size() + 7) / 8 * 8 + 8;
+    std::vector<std::uint64_t> threadCounts(generator.threads() * stride, 0);
+    generator.generate(n, [&](unsigned worker, std::uint64_t, const int* codes, std::size_t size) {
+        std::uint64_t* counts = threadCounts.data() + worker * stride;
+        for (std::size_t i = 0; i < size; i++) {
+            counts[index.index(codes[i])]++; // Increment the count for this error code
+        }
+        if (progress) {
+            progress->advance(size);
+        }
+    });
+
+    std::unordered_map<int, std::uint64_t> errorCounts;
+    for (std::uint32_t i = 0; i < index.size(); ++i) {
+        std::uint64_t count = 0;
+        for (unsigned worker = 0; worker < generator.threads(); ++worker) {
+            count += threadCounts[worker * stride + i];
+        }
+        if (count > 0) {
+            errorCounts[index.code(i)] = count;
+        }
+    }
+
+    return errorCounts;
+}
+
+// Function to draw the per-code counts of n draws directly from the multinomial distribution,
+// in O(number of codes) rather than O(n). Each count is a binomial draw conditioned on the draws
+// and weight still left, taken with the portable sampleBinomial(), so a seed gives the same
+// counts with every standard library. A queue whose counts are all zero yields n successes.
+// Throws std::invalid_argument if a code is not an integer (see parseErrorCode()).
+template <class URBG>
+std::unordered_map<int, std::uint64_t> sampleMultinomialCounts(const std::map<std::string, int>& error_codes,
+                                                               std::uint64_t n, URBG& gen) {
+    // Parse every code before drawing, so that a bad code fails whether or not it is drawn
+    std::vector<std::pair<int, int>> weights;
+    weights.reserve(error_codes.size());
+    long long remaining_weight = 0;
+    for (const auto& pair : error_codes) {
+        weights.emplace_back(parseErrorCode(pair.first), pair.second);
+        remaining_weight += pair.second;
+    }
+
+    std::unordered_map<int, std::uint64_t> errorCounts;
+
+    if (remaining_weight == 0 && !error_codes.empty()) {
+        // A queue without any counts always yields the success code, as ErrorCodeDistribution does
+        errorCounts[0] = n;
+        return errorCounts;
+    }
+
+    std::uint64_t remaining_n = n;
+    for (const auto& [code, weight] : weights) {
+        if (remaining_n == 0 || remaining_weight <= 0) {
+            break;
+        }
+        std::uint64_t count = remaining_n;
+        if (weight < remaining_weight) {
+            count = sampleBinomial(gen, remaining_n, static_cast<double>(weight) / remaining_weight);
+        }
+        remaining_n -= count;
+        remaining_weight -= weight;
+        if (count == 0) {
+            continue;
+        }
+        errorCounts[code] += count;
+    }
+
+    return errorCounts;
+}
+
+// Function to write a ROOT macro that fills and draws a histogram of errorCounts. Nothing is
+// written if errorCounts is empty.
+void generateROOTScript(const std::unordered_map<int, std::uint64_t>& errorCounts, const std::string& filename = "error_hist.C");
+
+#endif // HISTOGRAM_H
@@ -0,0 +1,145 @@
+// ==============================================
+// Description: Multi-threaded error code generation with reproducible
+//              streams. The output is split into fixed-size blocks and
+//              block b is always drawn from makeStream<Engine>(master seed,
+//              b), so the result does not depend on how many threads share
+//              the work. The seed and a position are therefore all it
+//              takes to checkpoint a run.
+// ==============================================
+
+#ifndef PARALLEL_GENERATOR_H
+#define PARALLEL_GENERATOR_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "error_code_distribution.h"
+#include "generator_checkpoint.h"
+#include "random_engines.h"
+
+template <class Engine = Xoshiro256StarStar>
+class BasicParallelGenerator {
+public:
+    // Number of codes drawn from one stream before moving on to the next block
+    static constexpr std::size_t kBlockSize = generator_checkpoint::kParallelBlockSize;
+
+    BasicParallelGenerator(std::shared_ptr<const ErrorCodeDistribution> distribution, std::uint64_t seed,
+                           unsigned threads)
+        : distribution_(std::move(distribution)), seed_(seed), threads_(std::max(threads, 1u)) {}
+
+    // This function generates n error codes and hands each block to
+    // consumer(unsigned worker, std::uint64_t offset, const int* codes, std::size_t size),
+    // where worker in [0, threads()) identifies the calling thread and offset is the position
+    // of codes[0] in the full sequence. The consumer is called concurrently from the worker
+    // threads, in no particular block order.
+    template <class Consumer>
+    void generate(std::uint64_t n, Consumer&& consumer) const {
+        const std::uint64_t blocks = (n + kBlockSize - 1) / kBlockSize;
+        std::atomic<std::uint64_t> nextBlock{0};
+        auto worker = [&](unsigned w) {
+            std::vector<int> buffer(kBlockSize);
+            for (std::uint64_t b = nextBlock++; b < blocks; b = nextBlock++) {
+                const std::uint64_t offset = b * kBlockSize;
+                const std::size_t size = static_cast<std::size_t>(std::min<std::uint64_t>(kBlockSize, n - offset));
+                Engine gen = makeStream<Engine>(seed_, b);
+                distribution_->fill(gen, buffer.data(), size);
+                consumer(w, offset, static_cast<const int*>(buffer.data()), size);
+            }
+        };
+        run(worker, static_cast<unsigned>(std::min<std::uint64_t>(threads_, blocks)));
+    }
+
+    // This function fills out[0..n) in parallel. Every thread writes its blocks in place.
+    void fill(int* out, std::uint64_t n) const {
+        fill(out, 0, n);
+    }
+
+    // This function fills out[0..n) with the codes at positions [first, first + n) of the full
+    // sequence, so that a long sequence can be produced in consecutive pieces. first must be a
+    // multiple of kBlockSize; throws std::invalid_argument otherwise.
+    void fill(int* out, std::uint64_t first, std::uint64_t n) const {
+        if (first % kBlockSize != 0) {
+            throw std::invalid_argument("Error: ParallelGenerator::fill() must start at a block boundary.");
+        }
+        const std::uint64_t firstBlock = first / kBlockSize;
+        const std::uint64_t blocks = (n + kBlockSize - 1) / kBlockSize;
+        std::atomic<std::uint64_t> nextBlock{0};
+        auto worker = [&](unsigned) {
+            for (std::uint64_t b = nextBlock++; b < blocks; b = nextBlock++) {
+                const std::uint64_t offset = b * kBlockSize;
+                const std::size_t size = static_cast<std::size_t>(std::min<std::uint64_t>(kBlockSize, n - offset));
+                Engine gen = makeStream<Engine>(seed_, firstBlock + b);
+                distribution_->fill(gen, out + offset, size);
+            }
+        };
+        run(worker, static_cast<unsigned>(std::min<std::uint64_t>(threads_, blocks)));
+    }
+
+    // This function returns the checkpoint state of a run that has produced the codes before
+    // position (see generator_checkpoint.h). A tool that writes the codes out can add its
+    // output details before it serializes the state. fill(out, position, n) continues the run,
+    // on any number of threads.
+    generator_checkpoint::State checkpointState(std::uint64_t position) const {
+        generator_checkpoint::State state;
+        state.kind = generator_checkpoint::Kind::Parallel;
+        state.engine = engineName<Engine>();
+        state.tableHash = generator_checkpoint::tableHash(*distribution_);
+        state.seed = seed_;
+        state.position = position;
+        return state;
+    }
+
+    std::vector<unsigned char> checkpoint(std::uint64_t position) const {
+        return generator_checkpoint::serialize(checkpointState(position));
+    }
+
+    const std::shared_ptr<const ErrorCodeDistribution>& distribution() const { return distribution_; }
+
+    unsigned threads() const { return threads_; }
+    std::uint64_t seed() const { return seed_; }
+
+private:
+    // Run worker(index) on the calling thread (index 0) plus (threads - 1) helpers. The first
+    // exception thrown by any of them is rethrown once all have finished.
+    template <class Worker>
+    static void run(Worker& worker, unsigned threads) {
+        std::exception_ptr error;
+        std::mutex errorMutex;
+        auto guarded = [&](unsigned index) {
+            try {
+                worker(index);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(errorMutex);
+                if (!error) {
+                    error = std::current_exception();
+                }
+            }
+        };
+        std::vector<std::thread> helpers;
+        for (unsigned t = 1; t < threads; ++t) {
+            helpers.emplace_back(guarded, t);
+        }
+        guarded(0);
+        for (auto& helper : helpers) {
+            helper.join();
+        }
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+    std::shared_ptr<const ErrorCodeDistribution> distribution_;
+    std::uint64_t seed_;
+    unsigned threads_;
+};
+
+using ParallelGenerator = BasicParallelGenerator<>;
+
+#endif // PARALLEL_GENERATOR_H
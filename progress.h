@@ -0,0 +1,44 @@
+// ==============================================
+// Description: Thread-safe progress reporting for long generation runs
+// ==============================================
+
+#ifndef PROGRESS_H
+#define PROGRESS_H
+
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+class ProgressReporter {
+public:
+    // The reporter prints a line to out whenever the completed percentage of total has grown.
+    ProgressReporter(std::uint64_t total, std::ostream& out) : total_(total), out_(out) {}
+
+    // This function records count more completed draws. It may be called from several
+    // threads at once; no percentage is printed twice.
+    void advance(std::uint64_t count) {
+        const std::uint64_t done = done_.fetch_add(count, std::memory_order_relaxed) + count;
+        const int percent = total_ == 0 ? 100 : static_cast<int>(static_cast<double>(done) * 100.0 / total_);
+        int printed = printed_.load(std::memory_order_relaxed);
+        while (percent > printed) {
+            if (printed_.compare_exchange_weak(printed, percent, std::memory_order_relaxed)) {
+                // One write per line, so that lines from different threads do not interleave
+                out_ << ("Progress: " + std::to_string(done) + " / " + std::to_string(total_) + " (" +
+                         std::to_string(percent) + "%)\n");
+                out_.flush();
+                break;
+            }
+        }
+    }
+
+    std::uint64_t done() const { return done_.load(std::memory_order_relaxed); }
+
+private:
+    std::uint64_t total_;
+    std::ostream& out_;
+    std::atomic<std::uint64_t> done_{0};
+    std::atomic<int> printed_{0};
+};
+
+#endif // PROGRESS_H
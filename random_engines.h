@@ -0,0 +1,399 @@
+// ==============================================
+// Description: Small, fast and portable 64-bit random engines that can be
+//              plugged into the error code generators: xoshiro256**,
+//              PCG64 (XSL-RR 128/64) and Philox4x32-10. All of them
+//              model UniformRandomBitGenerator and give the same sequence
+//              on every compiler and standard library. Their full state can
+//              be saved and restored for checkpoints.
+// ==============================================
+
+#ifndef RANDOM_ENGINES_H
+#define RANDOM_ENGINES_H
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// This function returns a non-deterministic 64-bit seed from std::random_device.
+inline std::uint64_t randomSeed() {
+    std::random_device rd;
+    return (static_cast<std::uint64_t>(rd()) << 32) | rd();
+}
+
+
+// SplitMix64 step, used to expand a 64-bit seed into engine state and to derive stream seeds.
+inline std::uint64_t splitMix64(std::uint64_t& state) {
+    std::uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+
+// xoshiro256** 1.0 (Blackman & Vigna): 32 bytes of state, period 2^256 - 1.
+class Xoshiro256StarStar {
+public:
+    using result_type = std::uint64_t;
+
+    explicit Xoshiro256StarStar(std::uint64_t seed = 0) { this->seed(seed); }
+
+    void seed(std::uint64_t seed) {
+        for (auto& word : s_) {
+            word = splitMix64(seed);
+        }
+    }
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+    result_type operator()() {
+        const std::uint64_t result = rotl(s_[1] * 5, 7) * 9;
+        const std::uint64_t t = s_[1] << 17;
+        s_[2] ^= s_[0];
+        s_[3] ^= s_[1];
+        s_[1] ^= s_[2];
+        s_[0] ^= s_[3];
+        s_[2] ^= t;
+        s_[3] = rotl(s_[3], 45);
+        return result;
+    }
+
+    // Advance the engine by 2^128 steps, e.g. to give each thread a non-overlapping stream.
+    void jump() {
+        static constexpr std::uint64_t kJump[] = {0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL,
+                                                  0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL};
+        std::uint64_t t[4] = {0, 0, 0, 0};
+        for (std::uint64_t word : kJump) {
+            for (int b = 0; b < 64; ++b) {
+                if (word & (1ULL << b)) {
+                    for (int i = 0; i < 4; ++i) {
+                        t[i] ^= s_[i];
+                    }
+                }
+                (*this)();
+            }
+        }
+        for (int i = 0; i < 4; ++i) {
+            s_[i] = t[i];
+        }
+    }
+
+    // The full state as kStateWords 64-bit words; setState() takes back what state() wrote.
+    // Throws std::invalid_argument for the all-zero state, which never leaves zero.
+    static constexpr std::size_t kStateWords = 4;
+
+    void state(std::uint64_t* words) const {
+        for (int i = 0; i < 4; ++i) {
+            words[i] = s_[i];
+        }
+    }
+
+    void setState(const std::uint64_t* words) {
+        if ((words[0] | words[1] | words[2] | words[3]) == 0) {
+            throw std::invalid_argument("Error: The all-zero state is not a valid xoshiro256** state.");
+        }
+        for (int i = 0; i < 4; ++i) {
+            s_[i] = words[i];
+        }
+    }
+
+private:
+    static std::uint64_t rotl(std::uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+
+    std::uint64_t s_[4];
+};
+
+
+// PCG64 (O'Neill): 128-bit LCG with the XSL-RR output function. Every odd increment selects
+// an independent stream, which is how BasicParallelGenerator separates its blocks.
+class Pcg64 {
+public:
+    using result_type = std::uint64_t;
+
+    explicit Pcg64(std::uint64_t seed = 0, std::uint64_t stream = 0) { this->seed(seed, stream); }
+
+    void seed(std::uint64_t seed, std::uint64_t stream = 0) {
+        inc_ = (static_cast<unsigned __int128>(stream) << 1) | 1;
+        state_ = 0;
+        step();
+        state_ += seed;
+        step();
+    }
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+    result_type operator()() {
+        step();
+        const std::uint64_t hi = static_cast<std::uint64_t>(state_ >> 64);
+        const std::uint64_t x = hi ^ static_cast<std::uint64_t>(state_);
+        const unsigned rot = static_cast<unsigned>(hi >> 58);
+        return (x >> rot) | (x << ((64 - rot) & 63));
+    }
+
+    // The full state as kStateWords 64-bit words: the LCG state and the increment, low half
+    // first. Throws std::invalid_argument if the increment is even.
+    static constexpr std::size_t kStateWords = 4;
+
+    void state(std::uint64_t* words) const {
+        words[0] = static_cast<std::uint64_t>(state_);
+        words[1] = static_cast<std::uint64_t>(state_ >> 64);
+        words[2] = static_cast<std::uint64_t>(inc_);
+        words[3] = static_cast<std::uint64_t>(inc_ >> 64);
+    }
+
+    void setState(const std::uint64_t* words) {
+        if ((words[2] & 1) == 0) {
+            throw std::invalid_argument("Error: A PCG64 increment must be odd.");
+        }
+        state_ = (static_cast<unsigned __int128>(words[1]) << 64) | words[0];
+        inc_ = (static_cast<unsigned __int128>(words[3]) << 64) | words[2];
+    }
+
+private:
+    void step() {
+        static constexpr unsigned __int128 kMultiplier =
+            (static_cast<unsigned __int128>(0x2360ed051fc65da4ULL) << 64) | 0x4385df649fccf645ULL;
+        state_ = state_ * kMultiplier + inc_;
+    }
+
+    unsigned __int128 state_;
+    unsigned __int128 inc_;
+};
+
+
+// Philox4x32-10 (Salmon et al., Random123): a counter-based engine. The output is a pure
+// function of (key, counter), so any position in any stream can be reached in O(1).
+class Philox4x32 {
+public:
+    using result_type = std::uint64_t;
+
+    explicit Philox4x32(std::uint64_t seed = 0, std::uint64_t stream = 0) { this->seed(seed, stream); }
+
+    // The seed is the key, the stream is the upper half of the 128-bit counter.
+    void seed(std::uint64_t seed, std::uint64_t stream = 0) {
+        key_[0] = static_cast<std::uint32_t>(seed);
+        key_[1] = static_cast<std::uint32_t>(seed >> 32);
+        counter_[0] = 0;
+        counter_[1] = 0;
+        counter_[2] = static_cast<std::uint32_t>(stream);
+        counter_[3] = static_cast<std::uint32_t>(stream >> 32);
+        // No block has been generated yet; zeroed so that a checkpoint of the state is deterministic
+        for (auto& word : block_) {
+            word = 0;
+        }
+        index_ = 2;
+    }
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+    // Each counter value yields one block of 4x32 bits, i.e. two 64-bit results.
+    result_type operator()() {
+        if (index_ == 2) {
+            generateBlock();
+            index_ = 0;
+        }
+        const result_type result = (static_cast<std::uint64_t>(block_[2 * index_ + 1]) << 32) | block_[2 * index_];
+        ++index_;
+        return result;
+    }
+
+    // Skip ahead by n results in O(1).
+    void discard(std::uint64_t n) {
+        // Position of the next result: two results per counter value
+        const std::uint64_t position = index_ == 2 ? 2 * counter() : 2 * (counter() - 1) + index_;
+        const std::uint64_t target = position + n;
+        setCounter(target / 2);
+        index_ = 2;
+        if (target % 2 != 0) {
+            (*this)();
+        }
+    }
+
+    // The full state as kStateWords 64-bit words: the key, the counter, the current block and
+    // the index of the next result in it. Throws std::invalid_argument for an invalid index.
+    static constexpr std::size_t kStateWords = 6;
+
+    void state(std::uint64_t* words) const {
+        words[0] = pack(key_[0], key_[1]);
+        words[1] = pack(counter_[0], counter_[1]);
+        words[2] = pack(counter_[2], counter_[3]);
+        words[3] = pack(block_[0], block_[1]);
+        words[4] = pack(block_[2], block_[3]);
+        words[5] = index_;
+    }
+
+    void setState(const std::uint64_t* words) {
+        if (words[5] > 2) {
+            throw std::invalid_argument("Error: Invalid Philox4x32 block index.");
+        }
+        std::uint32_t* halves[] = {key_, counter_, counter_ + 2, block_, block_ + 2};
+        for (int i = 0; i < 5; ++i) {
+            halves[i][0] = static_cast<std::uint32_t>(words[i]);
+            halves[i][1] = static_cast<std::uint32_t>(words[i] >> 32);
+        }
+        index_ = static_cast<unsigned>(words[5]);
+    }
+
+private:
+    static std::uint64_t pack(std::uint32_t lo, std::uint32_t hi) { return (static_cast<std::uint64_t>(hi) << 32) | lo; }
+
+    void generateBlock() {
+        std::uint32_t c[4] = {counter_[0], counter_[1], counter_[2], counter_[3]};
+        std::uint32_t k[2] = {key_[0], key_[1]};
+        for (int round = 0; round < 10; ++round) {
+            const std::uint64_t p0 = static_cast<std::uint64_t>(0xd2511f53u) * c[0];
+            const std::uint64_t p1 = static_cast<std::uint64_t>(0xcd9e8d57u) * c[2];
+            const std::uint32_t hi0 = static_cast<std::uint32_t>(p0 >> 32), lo0 = static_cast<std::uint32_t>(p0);
+            const std::uint32_t hi1 = static_cast<std::uint32_t>(p1 >> 32), lo1 = static_cast<std::uint32_t>(p1);
+            c[0] = hi1 ^ c[1] ^ k[0];
+            c[1] = lo1;
+            c[2] = hi0 ^ c[3] ^ k[1];
+            c[3] = lo0;
+            k[0] += 0x9e3779b9u;
+            k[1] += 0xbb67ae85u;
+        }
+        for (int i = 0; i < 4; ++i) {
+            block_[i] = c[i];
+        }
+        setCounter(counter() + 1);
+    }
+
+    // Only the low 64 bits of the counter advance; the upper half is the stream number.
+    std::uint64_t counter() const { return (static_cast<std::uint64_t>(counter_[1]) << 32) | counter_[0]; }
+
+    void setCounter(std::uint64_t value) {
+        counter_[0] = static_cast<std::uint32_t>(value);
+        counter_[1] = static_cast<std::uint32_t>(value >> 32);
+    }
+
+    std::uint32_t key_[2];
+    std::uint32_t counter_[4];
+    std::uint32_t block_[4];
+    unsigned index_;
+};
+
+
+// This function returns the engine for stream number stream of the given master seed. Engines
+// with native stream support use it; the others are seeded with a SplitMix64 mix of both.
+template <class Engine>
+Engine makeStream(std::uint64_t seed, std::uint64_t stream) {
+    std::uint64_t state = seed ^ splitMix64(stream);
+    return Engine(splitMix64(state));
+}
+
+template <>
+inline Pcg64 makeStream<Pcg64>(std::uint64_t seed, std::uint64_t stream) {
+    return Pcg64(seed, stream);
+}
+
+template <>
+inline Philox4x32 makeStream<Philox4x32>(std::uint64_t seed, std::uint64_t stream) {
+    return Philox4x32(seed, stream);
+}
+
+
+// Engine state for checkpoints: saveEngineState() copies the full state of an engine into
+// 64-bit words and loadEngineState() puts it back, so that the engine continues exactly where
+// it was. Both take O(state size), whatever the number of results drawn before.
+template <class Engine>
+std::vector<std::uint64_t> saveEngineState(const Engine& engine) {
+    std::vector<std::uint64_t> words(Engine::kStateWords);
+    engine.state(words.data());
+    return words;
+}
+
+// Throws std::invalid_argument if words is not a state of this engine.
+template <class Engine>
+void loadEngineState(Engine& engine, const std::vector<std::uint64_t>& words) {
+    if (words.size() != Engine::kStateWords) {
+        throw std::invalid_argument("Error: Wrong number of state words for this engine.");
+    }
+    engine.setState(words.data());
+}
+
+// std::mt19937_64 only exposes its state through its text form, a list of numbers (the 312
+// state words, and in libstdc++ also the position in them).
+template <>
+inline std::vector<std::uint64_t> saveEngineState<std::mt19937_64>(const std::mt19937_64& engine) {
+    std::stringstream text;
+    text << engine;
+    std::vector<std::uint64_t> words;
+    for (std::uint64_t word = 0; text >> word;) {
+        words.push_back(word);
+    }
+    return words;
+}
+
+template <>
+inline void loadEngineState<std::mt19937_64>(std::mt19937_64& engine, const std::vector<std::uint64_t>& words) {
+    std::stringstream text;
+    for (std::uint64_t word : words) {
+        text << word << ' ';
+    }
+    std::mt19937_64 loaded;
+    text >> loaded;
+    if (words.size() < std::mt19937_64::state_size || text.fail()) {
+        throw std::invalid_argument("Error: Invalid mt19937_64 state.");
+    }
+    engine = loaded;
+}
+
+
+// Engine selection by name, for command-line tools. withEngine() calls
+// function(EngineTag<Engine>{}) with the engine type that name stands for.
+template <class Engine>
+struct EngineTag {
+    using type = Engine;
+};
+
+inline bool isEngineName(const std::string& name) {
+    return name == "xoshiro256" || name == "pcg64" || name == "philox" || name == "mt19937";
+}
+
+template <class Function>
+void withEngine(const std::string& name, Function&& function) {
+    if (name == "xoshiro256") {
+        function(EngineTag<Xoshiro256StarStar>{});
+    } else if (name == "pcg64") {
+        function(EngineTag<Pcg64>{});
+    } else if (name == "philox") {
+        function(EngineTag<Philox4x32>{});
+    } else if (name == "mt19937") {
+        function(EngineTag<std::mt19937_64>{});
+    } else {
+        throw std::invalid_argument("Error: Unknown engine '" + name + "'.");
+    }
+}
+
+// This function returns the name withEngine() knows Engine by, e.g. to record it in a checkpoint.
+template <class Engine>
+const char* engineName();
+
+template <>
+inline const char* engineName<Xoshiro256StarStar>() {
+    return "xoshiro256";
+}
+
+template <>
+inline const char* engineName<Pcg64>() {
+    return "pcg64";
+}
+
+template <>
+inline const char* engineName<Philox4x32>() {
+    return "philox";
+}
+
+template <>
+inline const char* engineName<std::mt19937_64>() {
+    return "mt19937";
+}
+
+#endif // RANDOM_ENGINES_H
@@ -0,0 +1,28 @@
+// ==============================================
+// Description: Public interface of the random_errors library: random error
+//              code generators, the JSON and binary loaders and histograms
+// ==============================================
+
+#ifndef RANDOM_ERRORS_H
+#define RANDOM_ERRORS_H
+
+#include "code_writer.h"
+#include "dynamic_error_code_generator.h"
+#include "embedded_distribution.h"
+#include "error_code_binary.h"
+#include "error_code_distribution.h"
+#include "error_code_generator.h"
+#include "error_code_loader.h"
+#include "error_code_parser.h"
+#include "generator_checkpoint.h"
+#include "generator_registry.h"
+#include "histogram.h"
+#include "parallel_generator.h"
+#include "progress.h"
+#include "random_engines.h"
+#include "reloadable_distribution.h"
+#include "run_stats.h"
+#include "shared_ring.h"
+#include "socket_service.h"
+
+#endif // RANDOM_ERRORS_H
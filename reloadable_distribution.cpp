@@ -0,0 +1,132 @@
+// ==============================================
+// Description: Hot reloading of one queue's distribution (see
+//              reloadable_distribution.h)
+// ==============================================
+
+#include "reloadable_distribution.h"
+
+#include <algorithm>
+#include <iostream>
+#include <iterator>
+#include <stdexcept>
+#include <system_error>
+#include "error_code_loader.h"
+
+ReloadableDistribution::ReloadableDistribution(std::string input_file, std::string queue_name, FillMode mode)
+    : input_file_(std::move(input_file)), queue_name_(std::move(queue_name)), mode_(mode) {
+    std::error_code ec;
+    lastWrite_ = std::filesystem::last_write_time(input_file_, ec);
+    publish(load());
+}
+
+ReloadableDistribution::~ReloadableDistribution() {
+    stopWatching();
+}
+
+std::shared_ptr<const ErrorCodeDistribution> ReloadableDistribution::load() const {
+    std::shared_ptr<const ErrorCodeDistribution> tables = loadDistribution(input_file_, queue_name_, mode_);
+    if (!tables) {
+        throw std::runtime_error("Error: Site not found: " + queue_name_);
+    }
+    return tables;
+}
+
+void ReloadableDistribution::reload() {
+    publish(load());
+}
+
+void ReloadableDistribution::publish(std::shared_ptr<const ErrorCodeDistribution> tables) {
+    std::vector<Retired> freed;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        const std::uint64_t generation = generation_.load(std::memory_order_relaxed) + 1;
+        // The pointer is stored before the generation, so a reader that sees the new
+        // generation also sees the new pointer
+        published_.store(tables.get(), std::memory_order_release);
+        generation_.store(generation, std::memory_order_release);
+        if (current_) {
+            retired_.push_back({std::move(current_), generation});
+        }
+        current_ = std::move(tables);
+        freed = reclaim();
+    }
+    // The old tables are destroyed here, outside the lock
+}
+
+std::vector<ReloadableDistribution::Retired> ReloadableDistribution::reclaim() {
+    std::uint64_t oldest = generation_.load(std::memory_order_relaxed);
+    for (const auto& reader : readers_) {
+        oldest = std::min(oldest, reader->generation.load(std::memory_order_acquire));
+    }
+    std::vector<Retired> freed;
+    auto keep = std::partition(retired_.begin(), retired_.end(),
+                               [oldest](const Retired& r) { return r.generation > oldest; });
+    std::move(keep, retired_.end(), std::back_inserter(freed));
+    retired_.erase(keep, retired_.end());
+    return freed;
+}
+
+std::shared_ptr<const ErrorCodeDistribution> ReloadableDistribution::current() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return current_;
+}
+
+ReloadableDistribution::Reader* ReloadableDistribution::attach(const ErrorCodeDistribution*& tables) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    readers_.push_back(std::make_unique<Reader>());
+    readers_.back()->generation.store(generation_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    tables = current_.get();
+    return readers_.back().get();
+}
+
+void ReloadableDistribution::detach(Reader* reader) {
+    std::vector<Retired> freed;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        readers_.erase(std::remove_if(readers_.begin(), readers_.end(),
+                                      [reader](const std::unique_ptr<Reader>& r) { return r.get() == reader; }),
+                       readers_.end());
+        // The reader may have been the one holding back old tables
+        freed = reclaim();
+    }
+}
+
+void ReloadableDistribution::watch(std::chrono::milliseconds interval) {
+    stopWatching();
+    {
+        std::lock_guard<std::mutex> lock(watchMutex_);
+        stopping_ = false;
+    }
+    watcher_ = std::thread([this, interval] {
+        std::unique_lock<std::mutex> lock(watchMutex_);
+        while (!watchStop_.wait_for(lock, interval, [this] { return stopping_; })) {
+            std::error_code ec;
+            const auto lastWrite = std::filesystem::last_write_time(input_file_, ec);
+            if (!ec && lastWrite != lastWrite_) {
+                lastWrite_ = lastWrite;
+                try {
+                    reload();
+                } catch (const std::exception& e) {
+                    std::cerr << e.what() << std::endl;
+                }
+            }
+            // Old tables held back by a reader are freed on a later tick, once it has moved on
+            std::vector<Retired> freed;
+            {
+                std::lock_guard<std::mutex> writerLock(mutex_);
+                freed = reclaim();
+            }
+        }
+    });
+}
+
+void ReloadableDistribution::stopWatching() {
+    {
+        std::lock_guard<std::mutex> lock(watchMutex_);
+        stopping_ = true;
+    }
+    watchStop_.notify_all();
+    if (watcher_.joinable()) {
+        watcher_.join();
+    }
+}
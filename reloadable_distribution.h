@@ -0,0 +1,167 @@
+// ==============================================
+// Description: Hot reloading of one queue's distribution. New tables are
+//              built off the draw path and published with a single atomic
+//              pointer store (RCU style); generators pick them up without
+//              locking, and old tables are freed once no generator can
+//              still be using them.
+// ==============================================
+
+#ifndef RELOADABLE_DISTRIBUTION_H
+#define RELOADABLE_DISTRIBUTION_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "error_code_distribution.h"
+#include "random_engines.h"
+
+class ReloadableDistribution {
+public:
+    using FillMode = ErrorCodeDistribution::FillMode;
+
+    // Per-generator record of the last generation it has switched to. Old tables are freed
+    // only when every registered generator has moved past them.
+    struct alignas(64) Reader {
+        std::atomic<std::uint64_t> generation{0};
+    };
+
+    // The constructor loads queue_name from input_file (JSON or binary). Throws
+    // std::runtime_error if the file cannot be read or has no such queue.
+    ReloadableDistribution(std::string input_file, std::string queue_name, FillMode mode = FillMode::Auto);
+
+    // Stops the watcher thread. Every generator attached to this object must be destroyed first.
+    ~ReloadableDistribution();
+
+    ReloadableDistribution(const ReloadableDistribution&) = delete;
+    ReloadableDistribution& operator=(const ReloadableDistribution&) = delete;
+
+    // This function re-reads the input file, builds new tables and publishes them. The tables
+    // are built before anything is locked, so draws continue at full speed meanwhile. Throws
+    // std::runtime_error (and keeps the current tables) if the file cannot be loaded.
+    void reload();
+
+    // This function starts a background thread that checks the modification time of the input
+    // file every interval and calls reload() when it has changed. Load errors are reported on
+    // std::cerr and the current tables are kept.
+    void watch(std::chrono::milliseconds interval = std::chrono::milliseconds(1000));
+
+    // This function stops the watcher thread, if any.
+    void stopWatching();
+
+    // Number of tables published so far, starting at 1 for the initial load
+    std::uint64_t generation() const { return generation_.load(std::memory_order_acquire); }
+
+    // This function returns the current tables as an owning pointer, e.g. for a
+    // ParallelGenerator. It takes a lock and is not meant for the draw path.
+    std::shared_ptr<const ErrorCodeDistribution> current() const;
+
+    const std::string& inputFile() const { return input_file_; }
+    const std::string& queueName() const { return queue_name_; }
+
+    // Lock-free read side, used by BasicReloadingGenerator. refresh() returns the tables the
+    // reader should use from now on; it costs one atomic load unless a reload has happened.
+    Reader* attach(const ErrorCodeDistribution*& tables);
+    void detach(Reader* reader);
+
+    const ErrorCodeDistribution* refresh(Reader* reader, const ErrorCodeDistribution* tables) const {
+        const std::uint64_t generation = generation_.load(std::memory_order_acquire);
+        if (generation == reader->generation.load(std::memory_order_relaxed)) {
+            return tables;
+        }
+        tables = published_.load(std::memory_order_acquire);
+        // Everything read from the old tables happens before this store
+        reader->generation.store(generation, std::memory_order_release);
+        return tables;
+    }
+
+private:
+    struct Retired {
+        std::shared_ptr<const ErrorCodeDistribution> tables;
+        std::uint64_t generation; // Free once every reader has reached this generation
+    };
+
+    std::shared_ptr<const ErrorCodeDistribution> load() const;
+    void publish(std::shared_ptr<const ErrorCodeDistribution> tables);
+    std::vector<Retired> reclaim();
+
+    std::string input_file_;
+    std::string queue_name_;
+    FillMode mode_;
+
+    std::atomic<const ErrorCodeDistribution*> published_{nullptr};
+    std::atomic<std::uint64_t> generation_{0};
+
+    // Writer side: publishing, reclamation and (de)registration of readers
+    mutable std::mutex mutex_;
+    std::shared_ptr<const ErrorCodeDistribution> current_;
+    std::vector<Retired> retired_;
+    std::vector<std::unique_ptr<Reader>> readers_;
+
+    std::thread watcher_;
+    std::mutex watchMutex_;
+    std::condition_variable watchStop_;
+    bool stopping_{false};
+    std::filesystem::file_time_type lastWrite_{};
+};
+
+// Random error code generator that always draws from the latest tables of a
+// ReloadableDistribution. A draw never locks: it checks one atomic generation counter and
+// only on a change loads the new table pointer.
+template <class Engine = Xoshiro256StarStar>
+class BasicReloadingGenerator {
+public:
+    using engine_type = Engine;
+
+    BasicReloadingGenerator(ReloadableDistribution& source, std::uint64_t seed)
+        : BasicReloadingGenerator(source, Engine(seed)) {}
+
+    BasicReloadingGenerator(ReloadableDistribution& source, Engine engine)
+        : source_(source), gen_(std::move(engine)) {
+        reader_ = source_.attach(tables_);
+    }
+
+    ~BasicReloadingGenerator() { source_.detach(reader_); }
+
+    BasicReloadingGenerator(const BasicReloadingGenerator&) = delete;
+    BasicReloadingGenerator& operator=(const BasicReloadingGenerator&) = delete;
+
+    // This function returns the next random error code.
+    int getNextErrorCode() {
+        tables_ = source_.refresh(reader_, tables_);
+        return tables_->draw(gen_);
+    }
+
+    // This function fills a caller-provided buffer with the next count error codes. The whole
+    // buffer is drawn from one set of tables.
+    void fill(int* out, std::size_t count) {
+        tables_ = source_.refresh(reader_, tables_);
+        tables_->fill(gen_, out, count);
+    }
+
+    void fill(std::vector<int>& out) {
+        fill(out.data(), out.size());
+    }
+
+    // Generation of the tables the last draw used
+    std::uint64_t generation() const { return reader_->generation.load(std::memory_order_relaxed); }
+
+    Engine& engine() { return gen_; }
+
+private:
+    ReloadableDistribution& source_;
+    ReloadableDistribution::Reader* reader_{nullptr};
+    const ErrorCodeDistribution* tables_{nullptr};
+    Engine gen_;
+};
+
+using ReloadingGenerator = BasicReloadingGenerator<>;
+
+#endif // RELOADABLE_DISTRIBUTION_H
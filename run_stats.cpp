@@ -0,0 +1,113 @@
+// ==============================================
+// Description: Run statistics (see run_stats.h)
+// ==============================================
+
+#include "run_stats.h"
+
+#include <fstream>
+#include <nlohmann/json.hpp>
+#include <sys/resource.h>
+
+using json = nlohmann::json;
+
+
+void RunStats::phase(const std::string& name) {
+    stop();
+    current_ = phases_.size();
+    for (std::size_t i = 0; i < phases_.size(); ++i) {
+        if (phases_[i].name == name) {
+            current_ = i;
+        }
+    }
+    if (current_ == phases_.size()) {
+        phases_.push_back({name, 0.0});
+    }
+    running_ = true;
+    start_ = std::chrono::steady_clock::now();
+}
+
+void RunStats::stop() {
+    if (running_) {
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start_;
+        phases_[current_].seconds += elapsed.count();
+        running_ = false;
+    }
+}
+
+double RunStats::seconds(const std::string& name) const {
+    for (const Phase& p : phases_) {
+        if (p.name == name) {
+            return p.seconds;
+        }
+    }
+    return 0.0;
+}
+
+double RunStats::totalSeconds() const {
+    double total = 0.0;
+    for (const Phase& p : phases_) {
+        total += p.seconds;
+    }
+    return total;
+}
+
+double RunStats::drawsPerSecond() const {
+    const double drawSeconds = seconds("draw");
+    return drawSeconds > 0.0 ? static_cast<double>(draws_) / drawSeconds : 0.0;
+}
+
+std::uint64_t RunStats::bytesRead() {
+    // rchar counts every byte returned by read() and similar calls, including page cache hits
+    std::ifstream io("/proc/self/io");
+    std::string key;
+    std::uint64_t value = 0;
+    while (io >> key >> value) {
+        if (key == "rchar:") {
+            return value;
+        }
+    }
+    return 0;
+}
+
+std::uint64_t RunStats::peakMemoryBytes() {
+    struct rusage usage {};
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+    // ru_maxrss is in kilobytes on Linux
+    return static_cast<std::uint64_t>(usage.ru_maxrss) * 1024;
+}
+
+void RunStats::print(std::ostream& out) const {
+    out << "Stats:\n";
+    for (const Phase& p : phases_) {
+        out << "  " << p.name << ": " << p.seconds << " s\n";
+    }
+    out << "  total: " << totalSeconds() << " s\n";
+    out << "  draws: " << draws_ << "\n";
+    out << "  draws per second: " << drawsPerSecond() << "\n";
+    out << "  bytes read: " << bytesRead() << "\n";
+    out << "  peak memory: " << peakMemoryBytes() << " bytes\n";
+    if (hasAllocations_) {
+        out << "  allocations: " << allocations_ << " (" << allocatedBytes_ << " bytes)\n";
+    }
+    out.flush();
+}
+
+void RunStats::printJson(std::ostream& out) const {
+    json stats;
+    stats["phases"] = json::object();
+    for (const Phase& p : phases_) {
+        stats["phases"][p.name] = p.seconds;
+    }
+    stats["total_seconds"] = totalSeconds();
+    stats["draws"] = draws_;
+    stats["draws_per_second"] = drawsPerSecond();
+    stats["bytes_read"] = bytesRead();
+    stats["peak_memory_bytes"] = peakMemoryBytes();
+    if (hasAllocations_) {
+        stats["allocations"] = allocations_;
+        stats["allocated_bytes"] = allocatedBytes_;
+    }
+    out << stats.dump() << std::endl;
+}
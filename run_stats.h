@@ -0,0 +1,73 @@
+// ==============================================
+// Description: Run statistics for the tools and for embedding programs:
+//              wall time per phase, draws per second, bytes read, peak
+//              memory and (when the program counts them) allocations
+// ==============================================
+
+#ifndef RUN_STATS_H
+#define RUN_STATS_H
+
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+class RunStats {
+public:
+    struct Phase {
+        std::string name;
+        double seconds;
+    };
+
+    // This function ends the current phase, if any, and starts timing a new one. Phases with
+    // the same name are added up.
+    void phase(const std::string& name);
+
+    // This function ends the current phase.
+    void stop();
+
+    void addDraws(std::uint64_t draws) { draws_ += draws; }
+
+    // Allocation counts are only known to programs that replace operator new (the tools link
+    // allocation_counter.cpp), so they are passed in rather than measured here.
+    void setAllocations(std::uint64_t count, std::uint64_t bytes) {
+        allocations_ = count;
+        allocatedBytes_ = bytes;
+        hasAllocations_ = true;
+    }
+
+    const std::vector<Phase>& phases() const { return phases_; }
+
+    // Wall time of the named phase, 0 if it never ran
+    double seconds(const std::string& name) const;
+
+    // Wall time of all phases together
+    double totalSeconds() const;
+
+    std::uint64_t draws() const { return draws_; }
+
+    // Draws per second of wall time spent in the "draw" phase
+    double drawsPerSecond() const;
+
+    // Process counters: bytes read through read() system calls (Linux /proc/self/io, 0
+    // elsewhere; memory-mapped input is not included) and peak resident memory.
+    static std::uint64_t bytesRead();
+    static std::uint64_t peakMemoryBytes();
+
+    // Write the statistics as text, one item per line, or as one JSON object.
+    void print(std::ostream& out) const;
+    void printJson(std::ostream& out) const;
+
+private:
+    std::vector<Phase> phases_;
+    std::size_t current_{0};
+    bool running_{false};
+    std::chrono::steady_clock::time_point start_;
+    std::uint64_t draws_{0};
+    std::uint64_t allocations_{0};
+    std::uint64_t allocatedBytes_{0};
+    bool hasAllocations_{false};
+};
+
+#endif // RUN_STATS_H
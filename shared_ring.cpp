@@ -0,0 +1,252 @@
+// ==============================================
+// Description: Shared-memory rings of pre-generated error codes (see
+//              shared_ring.h)
+// ==============================================
+
+#include "shared_ring.h"
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <limits>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace shared_ring {
+
+namespace {
+
+std::uint64_t align64(std::uint64_t offset) {
+    return (offset + 63) & ~std::uint64_t{63};
+}
+
+QueueRing& ring(unsigned char* data, std::uint32_t queue) {
+    const auto* header = reinterpret_cast<const Header*>(data);
+    return reinterpret_cast<QueueRing*>(data + header->ringsOffset)[queue];
+}
+
+Slot& slot(unsigned char* data, const QueueRing& r, std::uint64_t position) {
+    const auto* header = reinterpret_cast<const Header*>(data);
+    return *reinterpret_cast<Slot*>(data + r.slotsOffset + (position % header->slotCount) * header->slotStride);
+}
+
+int* slotCodes(Slot& s) {
+    return reinterpret_cast<int*>(&s + 1);
+}
+
+} // namespace
+
+
+Producer::Producer(const std::string& name, GeneratorRegistry& registry,
+                   const std::vector<GeneratorRegistry::QueueHandle>& queues, std::uint32_t slotCount,
+                   std::uint32_t batchSize)
+    : name_(name), registry_(registry), queues_(queues) {
+    if (slotCount == 0 || batchSize == 0) {
+        throw std::invalid_argument("Error: Shared rings need at least one slot of at least one code.");
+    }
+
+    // Lay the object out
+    std::uint64_t namesSize = 0;
+    for (GeneratorRegistry::QueueHandle queue : queues_) {
+        namesSize += registry_.name(queue).size();
+    }
+    const std::uint64_t ringsOffset = align64(sizeof(Header));
+    const std::uint64_t namesOffset = ringsOffset + queues_.size() * sizeof(QueueRing);
+    const std::uint64_t slotStride = align64(sizeof(Slot) + std::uint64_t{batchSize} * sizeof(std::int32_t));
+    const std::uint64_t slotsOffset = align64(namesOffset + namesSize);
+    const std::uint64_t size = slotsOffset + queues_.size() * slotCount * slotStride;
+    if (namesSize > std::numeric_limits<std::uint32_t>::max() || size > std::numeric_limits<std::size_t>::max()) {
+        throw std::runtime_error("Error: Shared rings too large.");
+    }
+
+    // Replace any stale object of the same name, e.g. left behind by a killed producer
+    ::shm_unlink(name_.c_str());
+    const int fd = ::shm_open(name_.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+    if (fd < 0) {
+        throw std::runtime_error("Error: Could not create shared memory " + name_ + ": " + std::strerror(errno));
+    }
+    size_ = static_cast<std::size_t>(size);
+    void* mapping = MAP_FAILED;
+    if (::ftruncate(fd, static_cast<off_t>(size_)) == 0) {
+        mapping = ::mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    const int error = errno;
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        ::shm_unlink(name_.c_str());
+        throw std::runtime_error("Error: Could not map shared memory " + name_ + ": " + std::strerror(error));
+    }
+    data_ = static_cast<unsigned char*>(mapping);
+
+    // The object starts zero-filled; construct the header, rings and slots in place
+    auto* header = new (data_) Header{};
+    header->version = kVersion;
+    header->queueCount = static_cast<std::uint32_t>(queues_.size());
+    header->slotCount = slotCount;
+    header->batchSize = batchSize;
+    header->slotStride = slotStride;
+    header->ringsOffset = ringsOffset;
+    header->namesOffset = namesOffset;
+    header->size = size;
+    std::uint32_t nameOffset = 0;
+    for (std::uint32_t q = 0; q < queues_.size(); ++q) {
+        const std::string& queueName = registry_.name(queues_[q]);
+        auto* r = new (data_ + ringsOffset + q * sizeof(QueueRing)) QueueRing{};
+        r->nameOffset = nameOffset;
+        r->nameLength = static_cast<std::uint32_t>(queueName.size());
+        r->slotsOffset = slotsOffset + q * slotCount * slotStride;
+        std::memcpy(data_ + namesOffset + nameOffset, queueName.data(), queueName.size());
+        nameOffset += r->nameLength;
+        for (std::uint32_t i = 0; i < slotCount; ++i) {
+            auto* s = new (data_ + r->slotsOffset + i * slotStride) Slot{};
+            s->sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    // Build every distribution before the rings are announced, so that a bad queue fails here
+    for (GeneratorRegistry::QueueHandle queue : queues_) {
+        registry_.generator(queue);
+    }
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(header->magic, kMagic, sizeof(kMagic));
+}
+
+Producer::~Producer() {
+    if (data_ != nullptr) {
+        reinterpret_cast<Header*>(data_)->closed.store(1, std::memory_order_release);
+        ::munmap(data_, size_);
+        ::shm_unlink(name_.c_str());
+    }
+}
+
+std::size_t Producer::fillFreeSlots() {
+    const auto* header = reinterpret_cast<const Header*>(data_);
+    std::size_t batches = 0;
+    for (std::uint32_t q = 0; q < queues_.size(); ++q) {
+        QueueRing& r = ring(data_, q);
+        ErrorCodeGenerator& generator = registry_.generator(queues_[q]);
+        std::uint64_t position = r.tail.load(std::memory_order_relaxed);
+        for (;;) {
+            Slot& s = slot(data_, r, position);
+            if (s.sequence.load(std::memory_order_acquire) != position) {
+                break; // Full, or the oldest batch is still being copied out
+            }
+            generator.fill(slotCodes(s), header->batchSize);
+            s.sequence.store(position + 1, std::memory_order_release);
+            ++position;
+            ++batches;
+        }
+        r.tail.store(position, std::memory_order_relaxed);
+    }
+    produced_ += batches;
+    return batches;
+}
+
+void Producer::run(const std::atomic<bool>& stop) {
+    while (!stop.load(std::memory_order_relaxed)) {
+        if (fillFreeSlots() == 0) {
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+    }
+}
+
+
+Consumer::Consumer(const std::string& name) {
+    const int fd = ::shm_open(name.c_str(), O_RDWR, 0);
+    if (fd < 0) {
+        throw std::runtime_error("Error: Could not open shared memory " + name + ": " + std::strerror(errno));
+    }
+    struct stat st {};
+    if (::fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(Header))) {
+        ::close(fd);
+        throw std::runtime_error("Error: " + name + " is not a shared error code ring.");
+    }
+    size_ = static_cast<std::size_t>(st.st_size);
+    void* mapping = ::mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        throw std::runtime_error("Error: Could not map shared memory " + name);
+    }
+    header_ = static_cast<Header*>(mapping);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (std::memcmp(header_->magic, kMagic, sizeof(kMagic)) != 0 || header_->version != kVersion ||
+        header_->size != size_) {
+        ::munmap(mapping, size_);
+        throw std::runtime_error("Error: " + name + " is not a ready shared error code ring.");
+    }
+    auto* data = reinterpret_cast<unsigned char*>(header_);
+    for (std::uint32_t q = 0; q < header_->queueCount; ++q) {
+        const QueueRing& r = ring(data, q);
+        index_.emplace(std::string(reinterpret_cast<const char*>(data + header_->namesOffset + r.nameOffset),
+                                   r.nameLength),
+                       q);
+    }
+}
+
+Consumer::~Consumer() {
+    if (header_ != nullptr) {
+        ::munmap(header_, size_);
+    }
+}
+
+std::optional<std::uint32_t> Consumer::findQueue(std::string_view name) const {
+    const auto it = index_.find(std::string(name));
+    if (it == index_.end()) {
+        return std::nullopt;
+    }
+    return it->second;
+}
+
+std::size_t Consumer::tryClaim(std::uint32_t queue, int* out) {
+    if (queue >= header_->queueCount) {
+        throw std::out_of_range("Error: Queue index " + std::to_string(queue) + " is not in the shared memory rings.");
+    }
+    auto* data = reinterpret_cast<unsigned char*>(header_);
+    QueueRing& r = ring(data, queue);
+    std::uint64_t position = r.head.load(std::memory_order_relaxed);
+    for (;;) {
+        Slot& s = slot(data, r, position);
+        const std::uint64_t sequence = s.sequence.load(std::memory_order_acquire);
+        if (sequence == position + 1) {
+            // Filled: try to claim it; on failure position holds the new head
+            if (r.head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                std::memcpy(out, slotCodes(s), header_->batchSize * sizeof(int));
+                s.sequence.store(position + header_->slotCount, std::memory_order_release);
+                return header_->batchSize;
+            }
+        } else if (sequence < position + 1) {
+            return 0; // Not produced yet
+        } else {
+            position = r.head.load(std::memory_order_relaxed); // Claimed by another consumer
+        }
+    }
+}
+
+std::size_t Consumer::claim(std::uint32_t queue, int* out) {
+    for (unsigned attempt = 0;; ++attempt) {
+        // Check closed first, so that a batch produced just before closing is not lost
+        const bool wasClosed = closed();
+        if (const std::size_t n = tryClaim(queue, out)) {
+            return n;
+        }
+        if (wasClosed) {
+            return 0;
+        }
+        if (attempt < 64) {
+            continue;
+        }
+        if (attempt < 128) {
+            std::this_thread::yield();
+        } else {
+            std::this_thread::sleep_for(std::chrono::microseconds(20));
+        }
+    }
+}
+
+} // namespace shared_ring
@@ -0,0 +1,152 @@
+// ==============================================
+// Description: Lock-free single-producer/multi-consumer rings of
+//              pre-generated error codes in POSIX shared memory. One
+//              producer process keeps a ring per queue full; any number of
+//              consumer processes on the node claim whole batches from it.
+// ==============================================
+
+#ifndef SHARED_RING_H
+#define SHARED_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "generator_registry.h"
+
+namespace shared_ring {
+
+// Shared memory layout (offsets from the start of the object):
+//
+//   Header
+//   QueueRing rings[queueCount]
+//   char      names[]                      queue names, not NUL-terminated
+//   per queue, 64-byte aligned:
+//     slotCount slots of slotStride bytes: Slot, then int32_t codes[batchSize]
+//
+// Every slot carries a sequence number (Vyukov's bounded queue). Slot i of a ring holds batch
+// number pos (pos % slotCount == i) when its sequence is pos + 1, and is free for batch pos
+// when its sequence is pos. A consumer claims the next batch by advancing the ring's head
+// with a compare-and-swap, copies the codes out and hands the slot back to the producer by
+// setting its sequence to pos + slotCount. Nobody ever takes a lock.
+constexpr char kMagic[8] = {'R', 'N', 'D', 'E', 'R', 'R', 'S', 'H'};
+constexpr std::uint32_t kVersion = 1;
+
+struct Header {
+    char magic[8]; // Written last, once the rings are ready
+    std::uint32_t version;
+    std::uint32_t queueCount;
+    std::uint32_t slotCount;
+    std::uint32_t batchSize;
+    std::uint64_t slotStride;
+    std::uint64_t ringsOffset;
+    std::uint64_t namesOffset;
+    std::uint64_t size;
+    std::atomic<std::uint32_t> closed; // Set by the producer when it stops
+};
+
+struct alignas(64) QueueRing {
+    std::atomic<std::uint64_t> head; // Next batch to claim, advanced by consumers
+    char padding[56];
+    std::atomic<std::uint64_t> tail; // Next batch to produce, advanced by the producer only
+    std::uint32_t nameOffset;        // Relative to Header::namesOffset
+    std::uint32_t nameLength;
+    std::uint64_t slotsOffset;
+};
+
+struct Slot {
+    std::atomic<std::uint64_t> sequence;
+    std::uint64_t reserved;
+};
+
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "shared rings need lock-free 64-bit atomics");
+static_assert(std::atomic<std::uint32_t>::is_always_lock_free, "shared rings need lock-free 32-bit atomics");
+
+
+// The producer side. Creates the shared memory object and fills the rings from the
+// generators of a GeneratorRegistry.
+class Producer {
+public:
+    static constexpr std::uint32_t kDefaultSlots = 16;
+    static constexpr std::uint32_t kDefaultBatchSize = 4096;
+
+    // The constructor creates the shared memory object name (e.g. "/random_errors"),
+    // replacing any earlier object of that name, with one ring of slotCount batches of
+    // batchSize codes for each queue. Throws std::runtime_error if it cannot be created.
+    Producer(const std::string& name, GeneratorRegistry& registry,
+             const std::vector<GeneratorRegistry::QueueHandle>& queues, std::uint32_t slotCount = kDefaultSlots,
+             std::uint32_t batchSize = kDefaultBatchSize);
+
+    // Marks the rings closed, so that waiting consumers return, and removes the name.
+    ~Producer();
+
+    Producer(const Producer&) = delete;
+    Producer& operator=(const Producer&) = delete;
+
+    // This function fills every free slot of every ring and returns the number of batches
+    // produced.
+    std::size_t fillFreeSlots();
+
+    // This function keeps the rings full until stop becomes true, sleeping briefly whenever
+    // all of them are full.
+    void run(const std::atomic<bool>& stop);
+
+    std::uint64_t batchesProduced() const { return produced_; }
+    std::size_t size() const { return size_; }
+
+private:
+    std::string name_;
+    GeneratorRegistry& registry_;
+    std::vector<GeneratorRegistry::QueueHandle> queues_;
+    unsigned char* data_{nullptr};
+    std::size_t size_{0};
+    std::uint64_t produced_{0};
+};
+
+
+// The consumer side: the client API used by simulator processes.
+class Consumer {
+public:
+    // The constructor maps the shared memory object name created by a Producer. Throws
+    // std::runtime_error if it does not exist or is not a ring object.
+    explicit Consumer(const std::string& name);
+    ~Consumer();
+
+    Consumer(const Consumer&) = delete;
+    Consumer& operator=(const Consumer&) = delete;
+
+    // This function returns the index of queue name, or std::nullopt if it is not served.
+    std::optional<std::uint32_t> findQueue(std::string_view name) const;
+
+    // Number of codes in every batch, i.e. the size the out buffers below must have
+    std::uint32_t batchSize() const { return header_->batchSize; }
+
+    // Number of queues in the rings; queue indices are below it
+    std::uint32_t queueCount() const { return header_->queueCount; }
+
+    // This function claims the next batch of queue, copies it to out[0..batchSize()) and
+    // returns batchSize(), or returns 0 at once if the ring is empty. Throws std::out_of_range
+    // if queue is not below queueCount().
+    std::size_t tryClaim(std::uint32_t queue, int* out);
+
+    // The same, but waits (spinning, then yielding, then sleeping) while the ring is empty.
+    // Returns 0 only once the producer has stopped and the ring is empty. Throws
+    // std::out_of_range for a bad queue index, like tryClaim().
+    std::size_t claim(std::uint32_t queue, int* out);
+
+    // This function reports whether the producer has stopped.
+    bool closed() const { return header_->closed.load(std::memory_order_acquire) != 0; }
+
+private:
+    Header* header_{nullptr};
+    std::size_t size_{0};
+    std::unordered_map<std::string, std::uint32_t> index_;
+};
+
+} // namespace shared_ring
+
+#endif // SHARED_RING_H
@@ -0,0 +1,201 @@
+// ==============================================
+// Description: Scalar, AVX2 and AVX-512 kernels for SimdAliasKernel and
+//              the run-time dispatch between them
+// ==============================================
+
+#include "simd_alias_kernel.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define RANDOM_ERRORS_X86 1
+#endif
+
+namespace {
+
+using Lanes = SimdAliasKernel::Lanes;
+constexpr std::size_t kLanes = SimdAliasKernel::kLanes;
+
+// Signature shared by all kernels: fill groups * kLanes codes.
+using KernelFn = void (*)(Lanes&, const std::uint32_t*, const std::int32_t*, const std::int32_t*, std::uint32_t,
+                          int*, std::size_t);
+
+inline std::uint64_t rotl(std::uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+
+// One xoshiro256** step of lane j.
+inline std::uint64_t nextLane(Lanes& lanes, std::size_t j) {
+    std::uint64_t s0 = lanes.s[0][j], s1 = lanes.s[1][j], s2 = lanes.s[2][j], s3 = lanes.s[3][j];
+    const std::uint64_t result = rotl(s1 * 5, 7) * 9;
+    const std::uint64_t t = s1 << 17;
+    s2 ^= s0;
+    s3 ^= s1;
+    s1 ^= s2;
+    s0 ^= s3;
+    s2 ^= t;
+    s3 = rotl(s3, 45);
+    lanes.s[0][j] = s0;
+    lanes.s[1][j] = s1;
+    lanes.s[2][j] = s2;
+    lanes.s[3][j] = s3;
+    return result;
+}
+
+// The upper 32 bits pick the column by multiply-shift, the lower 32 bits are the fraction.
+inline std::int32_t lookup(std::uint64_t x, const std::uint32_t* threshold, const std::int32_t* code,
+                           const std::int32_t* alias, std::uint32_t k) {
+    const std::uint32_t column = static_cast<std::uint32_t>(((x >> 32) * k) >> 32);
+    return static_cast<std::uint32_t>(x) < threshold[column] ? code[column] : alias[column];
+}
+
+void fillScalarGroups(Lanes& lanes, const std::uint32_t* threshold, const std::int32_t* code,
+                      const std::int32_t* alias, std::uint32_t k, int* out, std::size_t groups) {
+    for (std::size_t g = 0; g < groups; ++g) {
+        for (std::size_t j = 0; j < kLanes; ++j) {
+            out[g * kLanes + j] = lookup(nextLane(lanes, j), threshold, code, alias, k);
+        }
+    }
+}
+
+#ifdef RANDOM_ERRORS_X86
+
+__attribute__((target("avx2")))
+void fillAvx2Groups(Lanes& lanes, const std::uint32_t* threshold, const std::int32_t* code,
+                    const std::int32_t* alias, std::uint32_t k, int* out, std::size_t groups) {
+    // Lanes 0-3 live in s[.][0], lanes 4-7 in s[.][1]
+    __m256i s[4][2];
+    for (int w = 0; w < 4; ++w) {
+        s[w][0] = _mm256_load_si256(reinterpret_cast<const __m256i*>(&lanes.s[w][0]));
+        s[w][1] = _mm256_load_si256(reinterpret_cast<const __m256i*>(&lanes.s[w][4]));
+    }
+    const __m256i kv = _mm256_set1_epi64x(k);
+    const __m256i evenWords = _mm256_setr_epi32(0, 2, 4, 6, 0, 0, 0, 0);
+    const __m128i sign = _mm_set1_epi32(INT32_MIN);
+    const int* thresholdBase = reinterpret_cast<const int*>(threshold);
+
+    for (std::size_t g = 0; g < groups; ++g) {
+        for (int h = 0; h < 2; ++h) {
+            __m256i s0 = s[0][h], s1 = s[1][h], s2 = s[2][h], s3 = s[3][h];
+            // result = rotl(s1 * 5, 7) * 9, with the multiplies done as shift-and-add
+            const __m256i m5 = _mm256_add_epi64(_mm256_slli_epi64(s1, 2), s1);
+            const __m256i r = _mm256_or_si256(_mm256_slli_epi64(m5, 7), _mm256_srli_epi64(m5, 57));
+            const __m256i x = _mm256_add_epi64(_mm256_slli_epi64(r, 3), r);
+            const __m256i t = _mm256_slli_epi64(s1, 17);
+            s2 = _mm256_xor_si256(s2, s0);
+            s3 = _mm256_xor_si256(s3, s1);
+            s1 = _mm256_xor_si256(s1, s2);
+            s0 = _mm256_xor_si256(s0, s3);
+            s2 = _mm256_xor_si256(s2, t);
+            s3 = _mm256_or_si256(_mm256_slli_epi64(s3, 45), _mm256_srli_epi64(s3, 19));
+            s[0][h] = s0;
+            s[1][h] = s1;
+            s[2][h] = s2;
+            s[3][h] = s3;
+
+            const __m256i column = _mm256_srli_epi64(_mm256_mul_epu32(_mm256_srli_epi64(x, 32), kv), 32);
+            const __m128i thr = _mm256_i64gather_epi32(thresholdBase, column, 4);
+            const __m128i cd = _mm256_i64gather_epi32(code, column, 4);
+            const __m128i al = _mm256_i64gather_epi32(alias, column, 4);
+            const __m128i frac = _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(x, evenWords));
+            // Unsigned frac < thr via a signed compare with the sign bits flipped
+            const __m128i keep = _mm_cmpgt_epi32(_mm_xor_si128(thr, sign), _mm_xor_si128(frac, sign));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + g * kLanes + 4 * h), _mm_blendv_epi8(al, cd, keep));
+        }
+    }
+
+    for (int w = 0; w < 4; ++w) {
+        _mm256_store_si256(reinterpret_cast<__m256i*>(&lanes.s[w][0]), s[w][0]);
+        _mm256_store_si256(reinterpret_cast<__m256i*>(&lanes.s[w][4]), s[w][1]);
+    }
+}
+
+__attribute__((target("avx512f,avx512vl")))
+void fillAvx512Groups(Lanes& lanes, const std::uint32_t* threshold, const std::int32_t* code,
+                      const std::int32_t* alias, std::uint32_t k, int* out, std::size_t groups) {
+    __m512i s0 = _mm512_load_si512(lanes.s[0]);
+    __m512i s1 = _mm512_load_si512(lanes.s[1]);
+    __m512i s2 = _mm512_load_si512(lanes.s[2]);
+    __m512i s3 = _mm512_load_si512(lanes.s[3]);
+    const __m512i kv = _mm512_set1_epi64(k);
+
+    for (std::size_t g = 0; g < groups; ++g) {
+        const __m512i m5 = _mm512_add_epi64(_mm512_slli_epi64(s1, 2), s1);
+        const __m512i r = _mm512_rol_epi64(m5, 7);
+        const __m512i x = _mm512_add_epi64(_mm512_slli_epi64(r, 3), r);
+        const __m512i t = _mm512_slli_epi64(s1, 17);
+        s2 = _mm512_xor_si512(s2, s0);
+        s3 = _mm512_xor_si512(s3, s1);
+        s1 = _mm512_xor_si512(s1, s2);
+        s0 = _mm512_xor_si512(s0, s3);
+        s2 = _mm512_xor_si512(s2, t);
+        s3 = _mm512_rol_epi64(s3, 45);
+
+        const __m512i column = _mm512_srli_epi64(_mm512_mul_epu32(_mm512_srli_epi64(x, 32), kv), 32);
+        const __m256i thr = _mm512_i64gather_epi32(column, threshold, 4);
+        const __m256i cd = _mm512_i64gather_epi32(column, code, 4);
+        const __m256i al = _mm512_i64gather_epi32(column, alias, 4);
+        const __mmask8 keep = _mm256_cmplt_epu32_mask(_mm512_cvtepi64_epi32(x), thr);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + g * kLanes), _mm256_mask_blend_epi32(keep, al, cd));
+    }
+
+    _mm512_store_si512(lanes.s[0], s0);
+    _mm512_store_si512(lanes.s[1], s1);
+    _mm512_store_si512(lanes.s[2], s2);
+    _mm512_store_si512(lanes.s[3], s3);
+}
+
+#endif // RANDOM_ERRORS_X86
+
+struct Dispatch {
+    KernelFn kernel;
+    const char* name;
+};
+
+const Dispatch& dispatch() {
+    static const Dispatch selected = []() -> Dispatch {
+#ifdef RANDOM_ERRORS_X86
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512vl")) {
+            return {fillAvx512Groups, "avx512"};
+        }
+        if (__builtin_cpu_supports("avx2")) {
+            return {fillAvx2Groups, "avx2"};
+        }
+#endif
+        return {fillScalarGroups, "scalar"};
+    }();
+    return selected;
+}
+
+// Full groups go through the kernel, the remainder is drawn from the first lanes in order.
+void fillWith(KernelFn kernel, Lanes& lanes, const std::uint32_t* threshold, const std::int32_t* code,
+              const std::int32_t* alias, std::uint32_t k, int* out, std::size_t count) {
+    const std::size_t groups = count / kLanes;
+    kernel(lanes, threshold, code, alias, k, out, groups);
+    for (std::size_t i = groups * kLanes, j = 0; i < count; ++i, ++j) {
+        out[i] = lookup(nextLane(lanes, j), threshold, code, alias, k);
+    }
+}
+
+} // namespace
+
+
+SimdAliasKernel::SimdAliasKernel(const AliasSampler& sampler) {
+    for (const auto& column : sampler.columns()) {
+        threshold_.push_back(static_cast<std::uint32_t>(column.threshold >> 32));
+        code_.push_back(column.code);
+        alias_.push_back(column.alias);
+    }
+}
+
+void SimdAliasKernel::fill(Lanes& lanes, int* out, std::size_t count) const {
+    fillWith(dispatch().kernel, lanes, threshold_.data(), code_.data(), alias_.data(),
+             static_cast<std::uint32_t>(code_.size()), out, count);
+}
+
+void SimdAliasKernel::fillScalar(Lanes& lanes, int* out, std::size_t count) const {
+    fillWith(fillScalarGroups, lanes, threshold_.data(), code_.data(), alias_.data(),
+             static_cast<std::uint32_t>(code_.size()), out, count);
+}
+
+const char* SimdAliasKernel::isa() {
+    return dispatch().name;
+}
@@ -0,0 +1,68 @@
+// ==============================================
+// Description: Vectorized bulk alias sampler. Eight xoshiro256** lanes run
+//              side by side and each lane's output selects a column of a
+//              32-bit structure-of-arrays alias table. The AVX-512 and AVX2
+//              kernels are chosen at run time and produce exactly the same
+//              codes as the scalar fallback.
+// ==============================================
+
+#ifndef SIMD_ALIAS_KERNEL_H
+#define SIMD_ALIAS_KERNEL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "alias_sampler.h"
+
+class SimdAliasKernel {
+public:
+    // Number of interleaved random streams; output i comes from lane i % kLanes.
+    static constexpr std::size_t kLanes = 8;
+    // Fills shorter than this are not worth seeding the lanes for.
+    static constexpr std::size_t kMinCount = 256;
+
+    // xoshiro256** state of all lanes, word-major so that one vector load gets one word of
+    // every lane.
+    struct alignas(64) Lanes {
+        std::uint64_t s[4][kLanes];
+
+        // Seed every lane from the caller's 64-bit engine.
+        template <class URBG>
+        void seed(URBG& gen) {
+            for (std::size_t w = 0; w < 4; ++w) {
+                for (std::size_t j = 0; j < kLanes; ++j) {
+                    s[w][j] = static_cast<std::uint64_t>(gen() - URBG::min());
+                }
+            }
+            // An all-zero xoshiro state would only ever produce zeros
+            for (std::size_t j = 0; j < kLanes; ++j) {
+                if ((s[0][j] | s[1][j] | s[2][j] | s[3][j]) == 0) {
+                    s[0][j] = 1;
+                }
+            }
+        }
+    };
+
+    SimdAliasKernel() = default;
+
+    // Convert an alias table to 32-bit thresholds in structure-of-arrays form.
+    explicit SimdAliasKernel(const AliasSampler& sampler);
+
+    // This function fills out[0..count) using the best kernel the CPU supports.
+    void fill(Lanes& lanes, int* out, std::size_t count) const;
+
+    // The same, always with the portable scalar kernel.
+    void fillScalar(Lanes& lanes, int* out, std::size_t count) const;
+
+    // Name of the kernel fill() dispatches to on this CPU: "avx512", "avx2" or "scalar".
+    static const char* isa();
+
+    std::size_t size() const { return code_.size(); }
+
+private:
+    std::vector<std::uint32_t> threshold_;
+    std::vector<std::int32_t> code_;
+    std::vector<std::int32_t> alias_;
+};
+
+#endif // SIMD_ALIAS_KERNEL_H
@@ -0,0 +1,103 @@
+// ==============================================
+// Description: Geometric skip-ahead sampler for queues dominated by the
+//              success code 0. Draws the gap to the next failure instead
+//              of every individual code.
+// ==============================================
+
+#ifndef SKIP_SAMPLER_H
+#define SKIP_SAMPLER_H
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include "alias_sampler.h"
+
+class SkipSampler {
+public:
+    // The error code that marks a successful job
+    static constexpr int kSuccessCode = 0;
+
+    // The next failure in the stream: how many successes precede it, and its error code.
+    struct Failure {
+        std::uint64_t gap;
+        int code;
+    };
+
+    SkipSampler() = default;
+
+    // Split the distribution into P(failure) and an alias table over the failure codes only.
+    SkipSampler(const std::vector<int>& codes, const std::vector<double>& weights) {
+        std::vector<int> failureCodes;
+        std::vector<double> failureWeights;
+        double total = 0.0;
+        double failureTotal = 0.0;
+        for (std::size_t i = 0; i < codes.size() && i < weights.size(); ++i) {
+            total += weights[i];
+            if (codes[i] != kSuccessCode && weights[i] > 0.0) {
+                failureCodes.push_back(codes[i]);
+                failureWeights.push_back(weights[i]);
+                failureTotal += weights[i];
+            }
+        }
+        failureProbability_ = total > 0.0 ? failureTotal / total : 0.0;
+        if (failureTotal > 0.0) {
+            failures_ = AliasSampler(failureCodes, failureWeights);
+            // log(1 - p), used to invert the geometric CDF
+            logSuccess_ = std::log1p(-failureProbability_);
+        }
+    }
+
+    double failureProbability() const { return failureProbability_; }
+
+    // This function returns the number of successes before the next failure. A queue without
+    // failures never fails, which is reported as UINT64_MAX.
+    template <class URBG>
+    std::uint64_t nextGap(URBG& gen) const {
+        if (failureProbability_ <= 0.0) {
+            return UINT64_MAX;
+        }
+        if (failureProbability_ >= 1.0) {
+            return 0;
+        }
+        // Uniform in (0, 1] from the top 53 bits, then invert the geometric CDF
+        const std::uint64_t x = static_cast<std::uint64_t>(gen() - URBG::min());
+        const double u = static_cast<double>((x >> 11) + 1) * 0x1.0p-53;
+        const double gap = std::floor(std::log(u) / logSuccess_);
+        return gap >= 18446744073709551615.0 ? UINT64_MAX : static_cast<std::uint64_t>(gap);
+    }
+
+    // This function returns the next failure: the gap to it and its error code.
+    template <class URBG>
+    Failure nextFailure(URBG& gen) const {
+        const std::uint64_t gap = nextGap(gen);
+        return {gap, gap == UINT64_MAX ? kSuccessCode : failures_(gen)};
+    }
+
+    // Fill out[0..count) by writing runs of successes with memset and drawing only the
+    // failures. The geometric distribution is memoryless, so a run cut off at the end of the
+    // buffer does not need to be carried over to the next call.
+    template <class URBG>
+    void fill(URBG& gen, int* out, std::size_t count) const {
+        static_assert(kSuccessCode == 0, "runs of successes are written with memset");
+        while (count > 0) {
+            const std::uint64_t gap = nextGap(gen);
+            if (gap >= count) {
+                std::memset(out, 0, count * sizeof(int));
+                return;
+            }
+            std::memset(out, 0, gap * sizeof(int));
+            out[gap] = failures_(gen);
+            out += gap + 1;
+            count -= gap + 1;
+        }
+    }
+
+private:
+    AliasSampler failures_;
+    double failureProbability_{0.0};
+    double logSuccess_{0.0};
+};
+
+#endif // SKIP_SAMPLER_H
@@ -0,0 +1,343 @@
+// ==============================================
+// Description: Unix domain socket server and client for batched error code
+//              draws (see socket_service.h)
+// ==============================================
+
+#include "socket_service.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace socket_service {
+
+namespace {
+
+// Responses waiting to be sent on one connection before the server stops reading its requests
+constexpr std::size_t kMaxPendingOutput = std::size_t{64} << 20;
+
+sockaddr_un socketAddress(const std::string& path) {
+    sockaddr_un address{};
+    if (path.size() >= sizeof(address.sun_path)) {
+        throw std::runtime_error("Error: Socket path too long: " + path);
+    }
+    address.sun_family = AF_UNIX;
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    return address;
+}
+
+template <class T>
+void append(std::vector<unsigned char>& buffer, const T& value) {
+    const auto* bytes = reinterpret_cast<const unsigned char*>(&value);
+    buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+}
+
+} // namespace
+
+
+Server::Server(const std::string& path, GeneratorRegistry& registry) : path_(path), registry_(registry) {
+    const sockaddr_un address = socketAddress(path_);
+    listenFd_ = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listenFd_ < 0) {
+        throw std::runtime_error(std::string("Error: Could not create a socket: ") + std::strerror(errno));
+    }
+    ::unlink(path_.c_str());
+    if (::bind(listenFd_, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 ||
+        ::listen(listenFd_, SOMAXCONN) != 0) {
+        const int error = errno;
+        ::close(listenFd_);
+        throw std::runtime_error("Error: Could not listen on " + path_ + ": " + std::strerror(error));
+    }
+    epollFd_ = ::epoll_create1(EPOLL_CLOEXEC);
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = listenFd_;
+    if (epollFd_ < 0 || ::epoll_ctl(epollFd_, EPOLL_CTL_ADD, listenFd_, &event) != 0) {
+        const int error = errno;
+        ::close(listenFd_);
+        ::unlink(path_.c_str());
+        throw std::runtime_error(std::string("Error: Could not create an epoll instance: ") + std::strerror(error));
+    }
+}
+
+Server::~Server() {
+    for (const auto& pair : connections_) {
+        ::close(pair.first);
+    }
+    ::close(epollFd_);
+    ::close(listenFd_);
+    ::unlink(path_.c_str());
+}
+
+void Server::run(const std::atomic<bool>& stop) {
+    epoll_event events[64];
+    while (!stop.load(std::memory_order_relaxed)) {
+        // Signals interrupt the wait, and the timeout bounds how long a missed one can go unseen
+        const int n = ::epoll_wait(epollFd_, events, 64, 200);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::runtime_error(std::string("Error: epoll_wait failed: ") + std::strerror(errno));
+        }
+        for (int i = 0; i < n; ++i) {
+            const int fd = events[i].data.fd;
+            if (fd == listenFd_) {
+                acceptConnections();
+                continue;
+            }
+            const auto it = connections_.find(fd);
+            if (it == connections_.end()) {
+                continue;
+            }
+            Connection& connection = *it->second;
+            bool open = (events[i].events & EPOLLERR) == 0;
+            // While too much output is pending, requests are left unread in the socket buffer
+            // so that a client that does not read its responses cannot grow the server's memory
+            if (open && (events[i].events & (EPOLLIN | EPOLLHUP)) && !connection.peerClosed &&
+                connection.out.size() - connection.sent < kMaxPendingOutput) {
+                open = receive(connection);
+            }
+            // Answer what has arrived; requests held back by a full output buffer are picked up
+            // again as soon as it drains
+            while (open) {
+                const std::size_t before = connection.in.size();
+                process(connection);
+                if (!send(connection)) {
+                    open = false;
+                    break;
+                }
+                if (connection.sent < connection.out.size() || connection.in.size() == before ||
+                    connection.in.empty()) {
+                    break;
+                }
+            }
+            // After the client's last request, close once every response to it is sent; what
+            // is left in the input can only be an incomplete request
+            if (open && connection.peerClosed && connection.out.empty()) {
+                open = false;
+            }
+            if (open) {
+                updateEvents(connection);
+            } else {
+                close(fd); // Responses the peer has not read yet are dropped with it
+            }
+        }
+    }
+}
+
+void Server::acceptConnections() {
+    for (;;) {
+        const int fd = ::accept4(listenFd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            return; // EAGAIN, or a client that gave up already
+        }
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = fd;
+        if (::epoll_ctl(epollFd_, EPOLL_CTL_ADD, fd, &event) != 0) {
+            ::close(fd);
+            continue;
+        }
+        connections_[fd] = std::make_unique<Connection>(Connection{fd, {}, {}, 0, EPOLLIN, false});
+    }
+}
+
+bool Server::receive(Connection& connection) {
+    unsigned char buffer[64 * 1024];
+    for (;;) {
+        const ssize_t n = ::recv(connection.fd, buffer, sizeof(buffer), 0);
+        if (n > 0) {
+            connection.in.insert(connection.in.end(), buffer, buffer + n);
+            continue;
+        }
+        if (n == 0) {
+            // An orderly shutdown of the client's side; the responses still go out
+            connection.peerClosed = true;
+            return true;
+        }
+        if (errno == EINTR) {
+            continue;
+        }
+        // EAGAIN means everything available has been read
+        return errno == EAGAIN || errno == EWOULDBLOCK;
+    }
+}
+
+void Server::process(Connection& connection) {
+    std::size_t offset = 0;
+    while (connection.in.size() - offset >= sizeof(RequestHeader) &&
+           connection.out.size() - connection.sent < kMaxPendingOutput) {
+        RequestHeader request;
+        std::memcpy(&request, connection.in.data() + offset, sizeof(request));
+        if (connection.in.size() - offset < sizeof(request) + request.nameLength) {
+            break; // The name has not fully arrived
+        }
+        const char* name = reinterpret_cast<const char*>(connection.in.data() + offset + sizeof(request));
+        offset += sizeof(request) + request.nameLength;
+        ++requests_;
+
+        if (request.op == kLookup) {
+            const std::optional<GeneratorRegistry::QueueHandle> queue =
+                registry_.find(std::string_view(name, request.nameLength));
+            append(connection.out, queue ? ResponseHeader{kOk, queue->index} : ResponseHeader{kUnknownQueue, 0});
+        } else if (request.op != kDraw || request.nameLength != 0) {
+            append(connection.out, ResponseHeader{kBadRequest, 0});
+        } else if (request.queue >= registry_.size()) {
+            append(connection.out, ResponseHeader{kUnknownQueue, 0});
+        } else if (request.count > kMaxCount) {
+            append(connection.out, ResponseHeader{kTooManyCodes, 0});
+        } else {
+            ErrorCodeGenerator* generator = nullptr;
+            try {
+                generator = &registry_.generator(GeneratorRegistry::QueueHandle{request.queue});
+            } catch (const std::exception&) {
+                // e.g. a queue without any error codes
+                append(connection.out, ResponseHeader{kBadRequest, 0});
+                continue;
+            }
+            append(connection.out, ResponseHeader{kOk, request.count});
+            // The codes are generated straight into the output buffer
+            const std::size_t at = connection.out.size();
+            connection.out.resize(at + std::size_t{request.count} * sizeof(int));
+            generator->fill(reinterpret_cast<int*>(connection.out.data() + at), request.count);
+        }
+    }
+    connection.in.erase(connection.in.begin(), connection.in.begin() + static_cast<std::ptrdiff_t>(offset));
+}
+
+bool Server::send(Connection& connection) {
+    while (connection.sent < connection.out.size()) {
+        const ssize_t n = ::send(connection.fd, connection.out.data() + connection.sent,
+                                 connection.out.size() - connection.sent, MSG_NOSIGNAL);
+        if (n > 0) {
+            connection.sent += static_cast<std::size_t>(n);
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        } else {
+            return false;
+        }
+    }
+    if (connection.sent == connection.out.size()) {
+        connection.out.clear();
+        connection.sent = 0;
+    }
+    return true;
+}
+
+void Server::updateEvents(Connection& connection) {
+    // Wait for room in the socket buffer only while there is something to send, and for
+    // requests only while the client may send more and the pending output is below the limit
+    const std::size_t pending = connection.out.size() - connection.sent;
+    const std::uint32_t events =
+        (pending != 0 ? static_cast<std::uint32_t>(EPOLLOUT) : std::uint32_t{0}) |
+        (!connection.peerClosed && pending < kMaxPendingOutput ? static_cast<std::uint32_t>(EPOLLIN) : std::uint32_t{0});
+    if (events != connection.events) {
+        epoll_event event{};
+        event.events = events;
+        event.data.fd = connection.fd;
+        ::epoll_ctl(epollFd_, EPOLL_CTL_MOD, connection.fd, &event);
+        connection.events = events;
+    }
+}
+
+void Server::close(int fd) {
+    ::epoll_ctl(epollFd_, EPOLL_CTL_DEL, fd, nullptr);
+    ::close(fd);
+    connections_.erase(fd);
+}
+
+
+Client::Client(const std::string& path) {
+    const sockaddr_un address = socketAddress(path);
+    fd_ = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd_ < 0 || ::connect(fd_, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+        const int error = errno;
+        if (fd_ >= 0) {
+            ::close(fd_);
+        }
+        throw std::runtime_error("Error: Could not connect to " + path + ": " + std::strerror(error));
+    }
+}
+
+Client::~Client() {
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+}
+
+std::optional<std::uint32_t> Client::lookup(std::string_view name) {
+    if (name.size() > UINT16_MAX) {
+        return std::nullopt;
+    }
+    append(pending_, RequestHeader{kLookup, 0, static_cast<std::uint16_t>(name.size()), 0, 0});
+    pending_.insert(pending_.end(), name.begin(), name.end());
+    flush();
+    ResponseHeader response;
+    receiveAll(&response, sizeof(response));
+    if (response.status != kOk) {
+        return std::nullopt;
+    }
+    return response.value;
+}
+
+void Client::draw(std::uint32_t queue, int* out, std::uint32_t count) {
+    sendDraw(queue, count);
+    receiveDraw(out);
+}
+
+void Client::sendDraw(std::uint32_t queue, std::uint32_t count) {
+    append(pending_, RequestHeader{kDraw, 0, 0, queue, count});
+}
+
+void Client::flush() {
+    std::size_t sent = 0;
+    while (sent < pending_.size()) {
+        const ssize_t n = ::send(fd_, pending_.data() + sent, pending_.size() - sent, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::runtime_error(std::string("Error: Failed to send a request: ") + std::strerror(errno));
+        }
+        sent += static_cast<std::size_t>(n);
+    }
+    pending_.clear();
+}
+
+std::uint32_t Client::receiveDraw(int* out) {
+    flush();
+    ResponseHeader response;
+    receiveAll(&response, sizeof(response));
+    if (response.status != kOk) {
+        throw std::runtime_error("Error: The server rejected a draw request (status " +
+                                 std::to_string(response.status) + ").");
+    }
+    receiveAll(out, std::size_t{response.value} * sizeof(int));
+    return response.value;
+}
+
+void Client::receiveAll(void* data, std::size_t size) {
+    auto* bytes = static_cast<unsigned char*>(data);
+    while (size > 0) {
+        const ssize_t n = ::recv(fd_, bytes, size, 0);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            throw std::runtime_error("Error: Lost the connection to the server.");
+        }
+        bytes += n;
+        size -= static_cast<std::size_t>(n);
+    }
+}
+
+} // namespace socket_service
@@ -0,0 +1,146 @@
+// ==============================================
+// Description: Local daemon serving batched error code draws over a Unix
+//              domain socket, and the client for it. All samplers stay
+//              resident in the server; requests use a compact binary
+//              protocol and may be pipelined.
+// ==============================================
+
+#ifndef SOCKET_SERVICE_H
+#define SOCKET_SERVICE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "generator_registry.h"
+
+namespace socket_service {
+
+// Protocol (native byte order, i.e. little-endian on every supported host). A client sends
+// requests, each a RequestHeader optionally followed by a queue name, and receives exactly one
+// response per request, in request order, so any number of requests may be in flight:
+//
+//   Lookup: {op = kLookup, nameLength, 0, 0} + name  ->  {status, queue index}
+//   Draw:   {op = kDraw, 0, queue index, count}      ->  {status, count} + int32_t codes[count]
+//
+// A draw returns the next count codes of the queue's generator, which the server shares
+// between all clients.
+constexpr std::uint8_t kLookup = 1;
+constexpr std::uint8_t kDraw = 2;
+
+constexpr std::uint32_t kOk = 0;
+constexpr std::uint32_t kUnknownQueue = 1;
+constexpr std::uint32_t kBadRequest = 2;
+constexpr std::uint32_t kTooManyCodes = 3;
+
+// Largest count a single draw request may ask for (64 MiB of codes)
+constexpr std::uint32_t kMaxCount = 1u << 24;
+
+struct RequestHeader {
+    std::uint8_t op;
+    std::uint8_t reserved;
+    std::uint16_t nameLength;
+    std::uint32_t queue;
+    std::uint32_t count;
+};
+
+struct ResponseHeader {
+    std::uint32_t status;
+    std::uint32_t value;
+};
+
+static_assert(sizeof(RequestHeader) == 12, "unexpected padding in RequestHeader");
+static_assert(sizeof(ResponseHeader) == 8, "unexpected padding in ResponseHeader");
+
+
+// Single-threaded epoll server. Every connection is served in request order; responses to a
+// batch of pipelined requests are sent together.
+class Server {
+public:
+    // The constructor binds and listens on the socket path, replacing a stale socket file.
+    // Throws std::runtime_error if that fails.
+    Server(const std::string& path, GeneratorRegistry& registry);
+
+    // Closes all connections and removes the socket file.
+    ~Server();
+
+    Server(const Server&) = delete;
+    Server& operator=(const Server&) = delete;
+
+    // This function serves clients until stop becomes true.
+    void run(const std::atomic<bool>& stop);
+
+    std::uint64_t requestsServed() const { return requests_; }
+
+private:
+    struct Connection {
+        int fd;
+        std::vector<unsigned char> in;
+        std::vector<unsigned char> out;
+        std::size_t sent{0};
+        std::uint32_t events{0};  // The epoll events the connection is registered for
+        bool peerClosed{false};   // The client has sent its last request
+    };
+
+    void acceptConnections();
+    bool receive(Connection& connection);
+    void process(Connection& connection);
+    bool send(Connection& connection);
+    void updateEvents(Connection& connection);
+    void close(int fd);
+
+    std::string path_;
+    GeneratorRegistry& registry_;
+    int listenFd_{-1};
+    int epollFd_{-1};
+    std::unordered_map<int, std::unique_ptr<Connection>> connections_;
+    std::uint64_t requests_{0};
+};
+
+
+// Blocking client. Requests can be queued with sendDraw() and their responses collected later
+// with receiveDraw() to keep several requests in flight.
+class Client {
+public:
+    // The constructor connects to the server at the socket path. Throws std::runtime_error if
+    // that fails.
+    explicit Client(const std::string& path);
+    ~Client();
+
+    Client(const Client&) = delete;
+    Client& operator=(const Client&) = delete;
+
+    // This function returns the server's index of queue name, or std::nullopt if it has no
+    // such queue.
+    std::optional<std::uint32_t> lookup(std::string_view name);
+
+    // This function draws count codes of queue into out[0..count). Throws std::runtime_error
+    // if the server rejects the request or the connection fails.
+    void draw(std::uint32_t queue, int* out, std::uint32_t count);
+
+    // Pipelining: queue a draw request without waiting for the response.
+    void sendDraw(std::uint32_t queue, std::uint32_t count);
+
+    // This function sends all queued requests.
+    void flush();
+
+    // This function sends any queued requests, then reads the response to the oldest
+    // outstanding draw into out, which must have room for the count that was requested, and
+    // returns the count.
+    std::uint32_t receiveDraw(int* out);
+
+private:
+    void receiveAll(void* data, std::size_t size);
+
+    int fd_{-1};
+    std::vector<unsigned char> pending_;
+};
+
+} // namespace socket_service
+
+#endif // SOCKET_SERVICE_H
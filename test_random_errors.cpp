@@ -0,0 +1,286 @@
+// ==============================================
+// Description: Tests of the random_errors library that need more than a
+//              tool run: checkpoints resuming a run exactly, the choice and
+//              results of the small exact search and the SIMD kernels
+//              against their scalar fallbacks. Each test is a named case;
+//              ctest runs them one by one, and without an argument all of
+//              them are run.
+// ==============================================
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "random_errors.h"
+
+namespace {
+
+using FillMode = ErrorCodeDistribution::FillMode;
+
+const std::string kInputFile = RANDOM_ERRORS_DATA_DIR "/error_codes.json";
+
+std::shared_ptr<const ErrorCodeDistribution> load(const std::string& queue, FillMode mode = FillMode::Auto) {
+    std::shared_ptr<const ErrorCodeDistribution> distribution = loadDistribution(kInputFile, queue, mode);
+    if (!distribution) {
+        throw std::runtime_error("Error: Unknown queue " + queue + " in " + kInputFile);
+    }
+    return distribution;
+}
+
+bool fail(const std::string& message) {
+    std::cerr << "Error: " << message << std::endl;
+    return false;
+}
+
+// A generator restored from a checkpoint continues with exactly the codes the original would
+// have drawn next, in every fill mode
+template <class Engine>
+bool streamResumes(FillMode mode) {
+    BasicErrorCodeGenerator<Engine> original(load("AGLT2", mode), 42);
+    std::vector<int> head(100003);
+    original.fill(head);
+    original.nextFailure();
+    const std::vector<unsigned char> checkpoint = original.checkpoint();
+
+    BasicErrorCodeGenerator<Engine> resumed(load("AGLT2", mode), 7);
+    resumed.restore(checkpoint);
+    std::vector<int> expected(200000);
+    std::vector<int> actual(expected.size());
+    original.fill(expected);
+    resumed.fill(actual);
+    if (actual != expected || resumed.position() != original.position()) {
+        return fail(std::string("a restored ") + engineName<Engine>() + " generator draws other codes");
+    }
+    return true;
+}
+
+bool testStreamCheckpointResume() {
+    bool ok = true;
+    for (FillMode mode : {FillMode::Auto, FillMode::Alias, FillMode::SkipAhead, FillMode::Vector, FillMode::Exact}) {
+        ok &= streamResumes<Xoshiro256StarStar>(mode);
+        ok &= streamResumes<Pcg64>(mode);
+        ok &= streamResumes<Philox4x32>(mode);
+        ok &= streamResumes<std::mt19937_64>(mode);
+    }
+    return ok;
+}
+
+// A parallel run resumed from a checkpoint, on another number of threads, writes the same
+// codes as a run that was never interrupted
+bool testParallelCheckpointResume() {
+    const std::shared_ptr<const ErrorCodeDistribution> distribution = load("AGLT2");
+    constexpr std::uint64_t kBlock = ParallelGenerator::kBlockSize;
+    const std::uint64_t n = 5 * kBlock + 1234;
+    const std::uint64_t position = 2 * kBlock;
+
+    ParallelGenerator full(distribution, 99, 3);
+    std::vector<int> expected(n);
+    full.fill(expected.data(), n);
+
+    generator_checkpoint::State state = full.checkpointState(position);
+    state.total = n;
+    const std::vector<unsigned char> blob = generator_checkpoint::serialize(state);
+    const generator_checkpoint::State restored = generator_checkpoint::deserialize(blob.data(), blob.size());
+    generator_checkpoint::verify(restored, generator_checkpoint::Kind::Parallel, engineName<Xoshiro256StarStar>(),
+                                 *distribution);
+
+    ParallelGenerator resumed(distribution, restored.seed, 1);
+    std::vector<int> actual(expected.begin(), expected.begin() + position);
+    actual.resize(n);
+    resumed.fill(actual.data() + position, restored.position, n - restored.position);
+    if (actual != expected) {
+        return fail("a resumed parallel run writes other codes than an uninterrupted one");
+    }
+    return true;
+}
+
+// verify() rejects positions a run cannot resume from
+bool testCheckpointPositionChecks() {
+    const std::shared_ptr<const ErrorCodeDistribution> distribution = load("AGLT2");
+    const ParallelGenerator generator(distribution, 1, 1);
+    auto accepted = [&](std::uint64_t position, std::uint64_t total) {
+        generator_checkpoint::State state = generator.checkpointState(position);
+        state.total = total;
+        try {
+            generator_checkpoint::verify(state, generator_checkpoint::Kind::Parallel,
+                                         engineName<Xoshiro256StarStar>(), *distribution);
+        } catch (const std::runtime_error&) {
+            return false;
+        }
+        return true;
+    };
+    constexpr std::uint64_t kBlock = ParallelGenerator::kBlockSize;
+    bool ok = true;
+    if (!accepted(0, 0) || !accepted(kBlock, 3 * kBlock + 5) || !accepted(3 * kBlock + 5, 3 * kBlock + 5)) {
+        ok = fail("verify() rejects a valid checkpoint position");
+    }
+    if (accepted(kBlock + 1, 3 * kBlock)) {
+        ok = fail("verify() accepts a position inside a block");
+    }
+    if (accepted(4 * kBlock, 3 * kBlock)) {
+        ok = fail("verify() accepts a position beyond the end of the run");
+    }
+    return ok;
+}
+
+// Auto mode draws single codes with the exact SIMD search from every queue small enough for
+// it, and with the alias table from the others; bulk fills keep the vector and skip-ahead kernels
+bool testAutoDrawsSmallQueuesExactly() {
+    bool ok = true;
+    for (const auto& [queue, counts] : loadAllQueues(kInputFile)) {
+        const ErrorCodeDistribution distribution(counts, FillMode::Auto);
+        if (distribution.isConstant()) {
+            continue;
+        }
+        std::uint64_t total = 0;
+        for (const auto& pair : counts) {
+            total += static_cast<std::uint64_t>(pair.second);
+        }
+        const bool small = counts.size() <= ExactSampler::kSmallSize && total <= UINT32_MAX;
+        if (distribution.exactDraws() != small) {
+            ok = fail("Auto mode of " + queue + " draws single codes with the wrong sampler");
+        }
+        if (distribution.fillMode() != FillMode::SkipAhead && distribution.fillMode() != FillMode::Vector) {
+            ok = fail("Auto mode of " + queue + " does not fill with the vector or skip-ahead kernel");
+        }
+    }
+    if (!load("praguelcg2")->exactDraws() || load("AGLT2", FillMode::Alias)->exactDraws()) {
+        ok = fail("exactDraws() does not follow the fill mode");
+    }
+    return ok;
+}
+
+// The code of the first cumulative count above r, by a plain scalar search
+int scalarSearch(const std::vector<int>& codes, const std::vector<std::uint64_t>& cumulative, std::uint64_t r) {
+    return codes[std::upper_bound(cumulative.begin(), cumulative.end(), r) - cumulative.begin()];
+}
+
+// The SIMD search of small queues finds the same code as a scalar search for every r at and
+// around the cumulative counts and for random r, and Auto mode draws agree with it
+bool testSmallExactSearchMatchesScalar() {
+    bool ok = true;
+    for (const auto& [queue, counts] : loadAllQueues(kInputFile)) {
+        std::vector<int> codes;
+        std::vector<std::uint64_t> weights;
+        std::vector<std::uint64_t> cumulative;
+        std::uint64_t total = 0;
+        for (const auto& pair : counts) {
+            codes.push_back(parseErrorCode(pair.first, queue));
+            weights.push_back(static_cast<std::uint64_t>(pair.second));
+            total += weights.back();
+            cumulative.push_back(total);
+        }
+        if (total == 0 || codes.size() > ExactSampler::kSmallSize) {
+            continue;
+        }
+        const ExactSampler sampler(codes, weights);
+        if (!sampler.small()) {
+            ok = fail(queue + " does not use the SIMD search");
+            continue;
+        }
+        std::vector<std::uint64_t> keys = {0, total - 1};
+        for (std::uint64_t c : cumulative) {
+            for (std::uint64_t r : {c - 1, c, c + 1}) {
+                if (r < total) {
+                    keys.push_back(r);
+                }
+            }
+        }
+        Xoshiro256StarStar gen(11);
+        for (int i = 0; i < 10000; ++i) {
+            keys.push_back(boundedRandom(gen, total));
+        }
+        for (std::uint64_t r : keys) {
+            if (sampler.code(r) != scalarSearch(codes, cumulative, r)) {
+                ok = fail("the SIMD search of " + queue + " finds another code than the scalar one for r = " +
+                          std::to_string(r));
+                break;
+            }
+        }
+
+        const ErrorCodeDistribution distribution(counts, FillMode::Auto);
+        if (!distribution.exactDraws()) {
+            continue;
+        }
+        Xoshiro256StarStar drawGen(5);
+        Xoshiro256StarStar referenceGen(5);
+        for (int i = 0; i < 10000; ++i) {
+            if (distribution.draw(drawGen) != scalarSearch(codes, cumulative, boundedRandom(referenceGen, total))) {
+                ok = fail("Auto mode draws from " + queue + " differ from the scalar search");
+                break;
+            }
+        }
+    }
+    return ok;
+}
+
+// The vectorized alias kernel this CPU dispatches to writes the same codes as its scalar
+// fallback, for lengths that end inside a group of lanes as well
+bool testVectorKernelMatchesScalar() {
+    bool ok = true;
+    for (const std::string& queue : {"AGLT2", "CERN", "praguelcg2"}) {
+        const SimdAliasKernel kernel(load(queue)->aliasSampler());
+        for (std::size_t count : {std::size_t{256}, std::size_t{1001}, std::size_t{65536}}) {
+            Xoshiro256StarStar gen(17);
+            SimdAliasKernel::Lanes vectorLanes;
+            vectorLanes.seed(gen);
+            SimdAliasKernel::Lanes scalarLanes = vectorLanes;
+            std::vector<int> vector(count);
+            std::vector<int> scalar(count);
+            kernel.fill(vectorLanes, vector.data(), count);
+            kernel.fillScalar(scalarLanes, scalar.data(), count);
+            if (vector != scalar) {
+                ok = fail(std::string("the ") + SimdAliasKernel::isa() +
+                          " kernel fills other codes than the scalar one for " + queue);
+            }
+        }
+    }
+    return ok;
+}
+
+const std::map<std::string, std::function<bool()>> kTests = {
+    {"stream_checkpoint_resume", testStreamCheckpointResume},
+    {"parallel_checkpoint_resume", testParallelCheckpointResume},
+    {"checkpoint_position_checks", testCheckpointPositionChecks},
+    {"auto_draws_small_queues_exactly", testAutoDrawsSmallQueuesExactly},
+    {"small_exact_search_matches_scalar", testSmallExactSearchMatchesScalar},
+    {"vector_kernel_matches_scalar", testVectorKernelMatchesScalar},
+};
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::vector<std::string> names;
+    for (int i = 1; i < argc; ++i) {
+        names.push_back(argv[i]);
+    }
+    if (names.empty()) {
+        for (const auto& pair : kTests) {
+            names.push_back(pair.first);
+        }
+    }
+
+    int failed = 0;
+    for (const std::string& name : names) {
+        const auto test = kTests.find(name);
+        if (test == kTests.end()) {
+            std::cerr << "Error: Unknown test " << name << std::endl;
+            return EXIT_FAILURE;
+        }
+        bool passed = false;
+        try {
+            passed = test->second();
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+        }
+        std::cout << name << ": " << (passed ? "passed" : "FAILED") << std::endl;
+        failed += passed ? 0 : 1;
+    }
+    return failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}